@@ -21,6 +21,61 @@
 #include "gcstruct.h"
 #include "extinit.h"
 
+/*
+ * QueryClientStats is particular to this server: it returns the request
+ * accounting Dispatch keeps for a client.  Times are in microseconds;
+ * 64 bit counters go out as a low and an overflow word, like the pixmap
+ * bytes.  The reply is followed by an xXResClientStats and num_opcodes
+ * xXResOpcodeStats, one for each major opcode the client has used.
+ */
+#define X_XResQueryClientStats		32
+
+typedef struct {
+    CARD8 reqType;
+    CARD8 XResReqType;
+    CARD16 length B16;
+    CARD32 xid B32;
+} xXResQueryClientStatsReq;
+#define sz_xXResQueryClientStatsReq 8
+
+typedef struct {
+    CARD8 type;
+    CARD8 pad1;
+    CARD16 sequenceNumber B16;
+    CARD32 length B32;
+    CARD32 num_opcodes B32;
+    CARD32 requests B32;
+    CARD32 pad2 B32;
+    CARD32 pad3 B32;
+    CARD32 pad4 B32;
+    CARD32 pad5 B32;
+} xXResQueryClientStatsReply;
+#define sz_xXResQueryClientStatsReply 32
+
+typedef struct {
+    CARD32 dispatch_time B32;
+    CARD32 dispatch_time_overflow B32;
+    CARD32 handler_time B32;
+    CARD32 handler_time_overflow B32;
+    CARD32 bytes_read B32;
+    CARD32 bytes_read_overflow B32;
+    CARD32 bytes_written B32;
+    CARD32 bytes_written_overflow B32;
+    CARD32 blocked_time B32;
+    CARD32 blocked_time_overflow B32;
+} xXResClientStats;
+#define sz_xXResClientStats 40
+
+typedef struct {
+    CARD8 major;
+    CARD8 pad1;
+    CARD16 pad2 B16;
+    CARD32 requests B32;
+    CARD32 time B32;
+    CARD32 time_overflow B32;
+} xXResOpcodeStats;
+#define sz_xXResOpcodeStats 16
+
 static int
 ProcXResQueryVersion(ClientPtr client)
 {
@@ -297,6 +352,105 @@ ProcXResQueryClientPixmapBytes(ClientPtr client)
     return (client->noClientException);
 }
 
+static int
+ProcXResQueryClientStats(ClientPtr client)
+{
+    REQUEST(xXResQueryClientStatsReq);
+    xXResQueryClientStatsReply rep;
+
+    xXResClientStats totals;
+
+    xXResOpcodeStats scratch;
+
+    ClientStatsRec *stats;
+
+    CARD64 time = 0, dispatch = 0;
+
+    int i, clientID, num_opcodes;
+
+    unsigned long requests;
+
+    REQUEST_SIZE_MATCH(xXResQueryClientStatsReq);
+
+    clientID = CLIENT_ID(stuff->xid);
+
+    if (!clientID || (clientID >= currentMaxClients) || !clients[clientID]) {
+        client->errorValue = stuff->xid;
+        return BadValue;
+    }
+    stats = &clients[clientID]->stats;
+#ifdef SMART_SCHEDULE
+    dispatch = clients[clientID]->smart_time;
+#endif
+
+    num_opcodes = 0;
+    requests = 0;
+    for (i = 0; i < 256; i++) {
+        if (!stats->requests[i])
+            continue;
+        num_opcodes++;
+        requests += stats->requests[i];
+        time += stats->time[i];
+    }
+
+    rep.type = X_Reply;
+    rep.sequenceNumber = client->sequence;
+    rep.length = (sz_xXResClientStats + num_opcodes * sz_xXResOpcodeStats) >> 2;
+    rep.num_opcodes = num_opcodes;
+    rep.requests = requests;
+    rep.pad2 = rep.pad3 = rep.pad4 = rep.pad5 = 0;
+
+#define ResSetCounter(field, value) { \
+    CARD64 v = (value); \
+    field = (CARD32) v; \
+    field##_overflow = (CARD32) (v >> 32); \
+}
+    ResSetCounter(totals.dispatch_time, dispatch);
+    ResSetCounter(totals.handler_time, time);
+    ResSetCounter(totals.bytes_read, stats->bytesRead);
+    ResSetCounter(totals.bytes_written, stats->bytesWritten);
+    ResSetCounter(totals.blocked_time,
+                  ClientWriteBlockedTime(clients[clientID]));
+
+    if (client->swapped) {
+        swaps(&rep.sequenceNumber);
+        swapl(&rep.length);
+        swapl(&rep.num_opcodes);
+        swapl(&rep.requests);
+        swapl(&totals.dispatch_time);
+        swapl(&totals.dispatch_time_overflow);
+        swapl(&totals.handler_time);
+        swapl(&totals.handler_time_overflow);
+        swapl(&totals.bytes_read);
+        swapl(&totals.bytes_read_overflow);
+        swapl(&totals.bytes_written);
+        swapl(&totals.bytes_written_overflow);
+        swapl(&totals.blocked_time);
+        swapl(&totals.blocked_time_overflow);
+    }
+    WriteToClient(client, sizeof(xXResQueryClientStatsReply), (char *) &rep);
+    WriteToClient(client, sz_xXResClientStats, (char *) &totals);
+
+    for (i = 0; i < 256; i++) {
+        if (!stats->requests[i])
+            continue;
+        scratch.major = i;
+        scratch.pad1 = 0;
+        scratch.pad2 = 0;
+        scratch.requests = stats->requests[i];
+        ResSetCounter(scratch.time, stats->time[i]);
+        if (client->swapped) {
+            swapl(&scratch.requests);
+            swapl(&scratch.time);
+            swapl(&scratch.time_overflow);
+        }
+        WriteToClient(client, sz_xXResOpcodeStats, (char *) &scratch);
+    }
+#undef ResSetCounter
+
+    return (client->noClientException);
+}
+
 static void
 ResResetProc(ExtensionEntry * extEntry)
 {
@@ -315,6 +469,8 @@ ProcResDispatch(ClientPtr client)
         return ProcXResQueryClientResources(client);
     case X_XResQueryClientPixmapBytes:
         return ProcXResQueryClientPixmapBytes(client);
+    case X_XResQueryClientStats:
+        return ProcXResQueryClientStats(client);
     default:
         break;
     }
@@ -349,6 +505,16 @@ SProcXResQueryClientPixmapBytes(ClientPtr client)
     return ProcXResQueryClientPixmapBytes(client);
 }
 
+static int
+SProcXResQueryClientStats(ClientPtr client)
+{
+    REQUEST(xXResQueryClientStatsReq);
+
+    REQUEST_SIZE_MATCH(xXResQueryClientStatsReq);
+    swapl(&stuff->xid);
+    return ProcXResQueryClientStats(client);
+}
+
 static int
 SProcResDispatch(ClientPtr client)
 {
@@ -365,6 +531,8 @@ SProcResDispatch(ClientPtr client)
         return SProcXResQueryClientResources(client);
     case X_XResQueryClientPixmapBytes:
         return SProcXResQueryClientPixmapBytes(client);
+    case X_XResQueryClientStats:
+        return SProcXResQueryClientStats(client);
     default:
         break;
     }
@@ -245,7 +245,7 @@ long SmartScheduleInterval = SMART_SCHEDULE_DEFAULT_INTERVAL;
 
 long SmartScheduleMaxSlice = SMART_SCHEDULE_MAX_SLICE;
 
-long SmartScheduleTime;
+CARD64 SmartScheduleTime;
 
 ClientPtr SmartLastClient;
 
@@ -254,7 +254,7 @@ int SmartLastIndex[SMART_MAX_PRIORITY - SMART_MIN_PRIORITY + 1];
 int SmartScheduleClient(int *clientReady, int nready);
 
 #ifdef SMART_DEBUG
-long SmartLastPrint;
+CARD64 SmartLastPrint;
 #endif
 
 void Dispatch(void);
@@ -272,13 +272,13 @@ SmartScheduleClient(int *clientReady, int nready)
 
     int bestRobin, robin;
 
-    long now = SmartScheduleTime;
+    CARD64 now = SmartScheduleTime;
 
-    long idle;
+    CARD64 idle;
 
     bestPrio = -0x7fffffff;
     bestRobin = 0;
-    idle = 2 * SmartScheduleSlice;
+    idle = SMART_USEC(2 * SmartScheduleSlice);
     for (i = 0; i < nready; i++) {
         client = clientReady[i];
         pClient = clients[client];
@@ -301,12 +301,12 @@ SmartScheduleClient(int *clientReady, int nready)
             best = client;
         }
 #ifdef SMART_DEBUG
-        if ((now - SmartLastPrint) >= 5000)
+        if ((now - SmartLastPrint) >= SMART_USEC(5000))
             fprintf(stderr, " %2d: %3d", client, pClient->smart_priority);
 #endif
     }
 #ifdef SMART_DEBUG
-    if ((now - SmartLastPrint) >= 5000) {
+    if ((now - SmartLastPrint) >= SMART_USEC(5000)) {
         fprintf(stderr, " use %2d\n", best);
         SmartLastPrint = now;
     }
@@ -329,7 +329,7 @@ SmartScheduleClient(int *clientReady, int nready)
          * has run, bump the slice up to get maximal
          * performance from a single client
          */
-        if ((now - pClient->smart_start_tick) > 1000 &&
+        if ((now - pClient->smart_start_tick) > SMART_USEC(1000) &&
             SmartScheduleSlice < SmartScheduleMaxSlice) {
             SmartScheduleSlice += SmartScheduleInterval;
         }
@@ -356,8 +356,14 @@ Dispatch(void)
 
     HWEventQueuePtr *icheck = checkForInput;
 
+    CARD64 start, now;
+
+    int major, minor, bytes, index;
+
+    CARD32 sequence;
+
 #ifdef SMART_SCHEDULE
-    long start_tick;
+    CARD64 start_tick;
 #endif
 
     nextFreeClientID = 1;
@@ -367,6 +373,8 @@ Dispatch(void)
     clientReady = (int *) ALLOCATE_LOCAL(sizeof(int) * MaxClients);
     if (!clientReady)
         return;
+    if (DispatchTraceEnabled)
+        DispatchTraceInit();
 
     while (!dispatchException) {
         if (*icheck[0] != *icheck[1]) {
@@ -375,9 +383,11 @@ Dispatch(void)
         }
 
         nready = WaitForSomething(clientReady);
+        ScratchReset();
 
 #ifdef SMART_SCHEDULE
         if (nready && !SmartScheduleDisable) {
+            SmartScheduleTime = GetTimeInMicros();
             clientReady[0] = SmartScheduleClient(clientReady, nready);
             nready = 1;
         }
@@ -402,7 +412,7 @@ Dispatch(void)
 
             requestingClient = client;
 #ifdef SMART_SCHEDULE
-            start_tick = SmartScheduleTime;
+            start_tick = SmartScheduleTime = GetTimeInMicros();
 #endif
             while (!isItTimeToYield) {
                 if (*icheck[0] != *icheck[1]) {
@@ -410,9 +420,11 @@ Dispatch(void)
                     FlushIfCriticalOutputPending();
                 }
 #ifdef SMART_SCHEDULE
+                /* the clock was read as the last request finished */
                 if (!SmartScheduleDisable &&
-                    (SmartScheduleTime - start_tick) >= SmartScheduleSlice) {
-                    /* Penalize clients which consume ticks */
+                    (SmartScheduleTime - start_tick) >=
+                    SMART_USEC(SmartScheduleSlice)) {
+                    /* Penalize clients which consume their slice */
                     if (client->smart_priority > SMART_MIN_PRIORITY)
                         client->smart_priority--;
                     break;
@@ -434,10 +446,29 @@ Dispatch(void)
                 client->requestLog[client->requestLogIndex] = MAJOROP;
                 client->requestLogIndex++;
 #endif
+                major = MAJOROP;
+                minor = DispatchTraceEnabled ? MinorOpcodeOfRequest(client) : 0;
+                bytes = result;
+                index = client->index;
+                sequence = client->sequence;
+                client->stats.requests[major]++;
+                start = GetTimeInMicros();
                 if (result > (maxBigRequestSize << 2))
                     result = BadLength;
                 else
-                    result = (*client->requestVector[MAJOROP]) (client);
+                    result = (*client->requestVector[major]) (client);
+                now = GetTimeInMicros();
+                /* a client killing itself is gone by now */
+                if (clients[index] == client)
+                    client->stats.time[major] += now - start;
+                if (DispatchTraceEnabled)
+                    DispatchTrace(index, sequence, major, minor, bytes,
+                                  start, now);
+#ifdef SMART_SCHEDULE
+                SmartScheduleTime = now;
+#endif
+                /* nothing the request took from the scratch arena is live */
+                ScratchReset();
 
                 if (result != Success) {
                     if (client->noClientException != Success)
@@ -451,14 +482,19 @@ Dispatch(void)
             }
             FlushAllOutput();
 #ifdef SMART_SCHEDULE
+            SmartScheduleTime = GetTimeInMicros();
             client = clients[clientReady[nready]];
-            if (client)
+            if (client) {
                 client->smart_stop_tick = SmartScheduleTime;
+                client->smart_time += SmartScheduleTime - start_tick;
+            }
 #endif
             requestingClient = NULL;
         }
         dispatchException &= ~DE_PRIORITYCHANGE;
     }
+    if (DispatchTraceEnabled && DispatchTraceFile)
+        DispatchTraceDump();
     KillAllClients();
     DEALLOCATE_LOCAL(clientReady);
     dispatchException &= ~DE_RESET;
@@ -467,6 +503,50 @@ Dispatch(void)
 
 #undef MAJOROP
 
+/*
+ * Write every client's request accounting to the log, one line per
+ * client followed by the major opcodes it used.
+ */
+void
+ClientStatsDump(void)
+{
+    ClientPtr client;
+
+    ClientStatsRec *stats;
+
+    unsigned long requests;
+
+    CARD64 time;
+
+    int i, major;
+
+    ErrorF("Request accounting (times in microseconds):\n");
+    for (i = 1; i < currentMaxClients; i++) {
+        client = clients[i];
+        if (!client || client->clientState != ClientStateRunning)
+            continue;
+        stats = &client->stats;
+        requests = 0;
+        time = 0;
+        for (major = 0; major < 256; major++) {
+            requests += stats->requests[major];
+            time += stats->time[major];
+        }
+        ErrorF("client %d (0x%lx): %lu requests, %llu in handlers, "
+               "%llu bytes read, %llu written, %llu write blocked\n",
+               i, (unsigned long) client->clientAsMask, requests,
+               (unsigned long long) time,
+               (unsigned long long) stats->bytesRead,
+               (unsigned long long) stats->bytesWritten,
+               (unsigned long long) ClientWriteBlockedTime(client));
+        for (major = 0; major < 256; major++)
+            if (stats->requests[major])
+                ErrorF("    major %3d: %lu requests, %llu\n", major,
+                       (unsigned long) stats->requests[major],
+                       (unsigned long long) stats->time[major]);
+    }
+}
+
 _X_EXPORT int
 ProcBadRequest(ClientPtr client)
 {
@@ -3557,7 +3637,9 @@ InitClient(ClientPtr client, int i, pointer ospriv)
     client->smart_start_tick = SmartScheduleTime;
     client->smart_stop_tick = SmartScheduleTime;
     client->smart_check_tick = SmartScheduleTime;
+    client->smart_time = 0;
 #endif
+    memset(&client->stats, 0, sizeof(ClientStatsRec));
 }
 
 int
@@ -0,0 +1,266 @@
+/*
+ *
+ * Copyright © 2026 Ace Husky <acehusky12@gmail.com>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of Ace Husky not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  Ace Husky makes no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * ACE HUSKY DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL ACE HUSKY BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Dispatch tracing.
+ *
+ * With tracing on, Dispatch hands every request it runs to DispatchTrace,
+ * which puts a record of it in a ring of the last DispatchTraceSize
+ * requests and counts its latency in a per-major-opcode histogram of
+ * power of two buckets.  Only Dispatch writes, so the ring is no more
+ * than an array and a running count; dumps are taken between requests.
+ *
+ * Tracing is switched on with -trace or by the first SIGUSR2.  Each
+ * SIGUSR2 after that, and the end of every server generation, dumps the
+ * ring and the histograms to the -trace file, as CSV or with -tracebinary
+ * in the layout below, or as CSV to the log when no file was given.
+ * Both are cleared by a dump, so each one covers the requests since the
+ * one before.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <X11/X.h>
+#include "misc.h"
+#include "os.h"
+#include "opaque.h"
+#include "dixstruct.h"
+
+#define TRACE_BUCKETS	32
+#define TRACE_MAGIC	0x43525458      /* "XTRC" */
+#define TRACE_VERSION	1
+
+typedef struct _DispatchTraceRecord {
+    CARD64 start;               /* microseconds, monotonic */
+    CARD64 end;
+    CARD32 sequence;
+    CARD32 bytes;               /* request length */
+    CARD16 client;
+    CARD8 major;
+    CARD8 pad;
+    CARD16 minor;
+    CARD16 pad2;
+} DispatchTraceRecordRec;
+
+/*
+ * A binary dump is this header, nrecords records oldest first, then
+ * 256 x TRACE_BUCKETS CARD32 bucket counts, all in server byte order.
+ * Bucket 0 counts requests under a microsecond, bucket n those taking
+ * 2^(n-1) up to 2^n microseconds.
+ */
+typedef struct _DispatchTraceHeader {
+    CARD32 magic;
+    CARD16 version;
+    CARD16 recordSize;
+    CARD32 nrecords;
+    CARD32 nbuckets;
+} DispatchTraceHeaderRec;
+
+Bool DispatchTraceEnabled;
+
+char *DispatchTraceFile;
+
+Bool DispatchTraceBinary;
+
+int DispatchTraceSize = 65536;
+
+static DispatchTraceRecordRec *traceRing;
+
+static unsigned int traceMask;
+
+static CARD64 traceCount;       /* records written since the last dump */
+
+static CARD32 traceHistogram[256][TRACE_BUCKETS];
+
+Bool
+DispatchTraceInit(void)
+{
+    int size = 1;
+
+    if (traceRing)
+        return TRUE;
+    while (size < DispatchTraceSize && size < DISPATCH_TRACE_MAX_SIZE)
+        size <<= 1;
+    traceRing = calloc(size, sizeof(DispatchTraceRecordRec));
+    if (!traceRing) {
+        ErrorF("Dispatch tracing: can't allocate %d records\n", size);
+        DispatchTraceEnabled = FALSE;
+        return FALSE;
+    }
+    traceMask = size - 1;
+    traceCount = 0;
+    memset(traceHistogram, 0, sizeof(traceHistogram));
+    DispatchTraceEnabled = TRUE;
+    return TRUE;
+}
+
+/*
+ * Called once the request has run, which may have freed the client, so
+ * it is passed by index.
+ */
+void
+DispatchTrace(int client, CARD32 sequence, int major, int minor, int bytes,
+              CARD64 start, CARD64 end)
+{
+    DispatchTraceRecordRec *rec = &traceRing[traceCount++ & traceMask];
+
+    CARD64 elapsed = end - start;
+
+    int bucket = 0;
+
+    rec->start = start;
+    rec->end = end;
+    rec->sequence = sequence;
+    rec->bytes = bytes;
+    rec->client = client;
+    rec->major = major;
+    rec->minor = minor;
+
+    while (elapsed && bucket < TRACE_BUCKETS - 1) {
+        elapsed >>= 1;
+        bucket++;
+    }
+    traceHistogram[major][bucket]++;
+}
+
+static void
+DispatchTraceLine(FILE * f, const char *line)
+{
+    if (f)
+        fputs(line, f);
+    else
+        ErrorF("%s", line);
+}
+
+static void
+DispatchTraceCSV(FILE * f)
+{
+    DispatchTraceRecordRec *rec;
+
+    char line[256];
+
+    int len;
+
+    CARD64 i;
+
+    int major, bucket;
+
+    DispatchTraceLine(f, "client,major,minor,sequence,start,end,bytes\n");
+    i = traceCount > traceMask ? traceCount - traceMask - 1 : 0;
+    for (; i != traceCount; i++) {
+        rec = &traceRing[i & traceMask];
+        snprintf(line, sizeof(line), "%u,%u,%u,%lu,%llu,%llu,%lu\n",
+                 rec->client, rec->major, rec->minor,
+                 (unsigned long) rec->sequence,
+                 (unsigned long long) rec->start,
+                 (unsigned long long) rec->end, (unsigned long) rec->bytes);
+        DispatchTraceLine(f, line);
+    }
+
+    /* then one row of bucket counts for each major opcode seen */
+    len = snprintf(line, sizeof(line), "major");
+    for (bucket = 0; bucket < TRACE_BUCKETS; bucket++)
+        len += snprintf(line + len, sizeof(line) - len, ",%d", bucket);
+    snprintf(line + len, sizeof(line) - len, "\n");
+    DispatchTraceLine(f, line);
+    for (major = 0; major < 256; major++) {
+        for (bucket = 0; bucket < TRACE_BUCKETS; bucket++)
+            if (traceHistogram[major][bucket])
+                break;
+        if (bucket == TRACE_BUCKETS)
+            continue;
+        len = snprintf(line, sizeof(line), "%d", major);
+        for (bucket = 0; bucket < TRACE_BUCKETS; bucket++)
+            len += snprintf(line + len, sizeof(line) - len, ",%lu",
+                            (unsigned long) traceHistogram[major][bucket]);
+        snprintf(line + len, sizeof(line) - len, "\n");
+        DispatchTraceLine(f, line);
+    }
+}
+
+static void
+DispatchTraceBinaryDump(FILE * f)
+{
+    DispatchTraceHeaderRec header;
+
+    CARD64 first;
+
+    CARD32 n, start;
+
+    first = traceCount > traceMask ? traceCount - traceMask - 1 : 0;
+    n = traceCount - first;
+    header.magic = TRACE_MAGIC;
+    header.version = TRACE_VERSION;
+    header.recordSize = sizeof(DispatchTraceRecordRec);
+    header.nrecords = n;
+    header.nbuckets = TRACE_BUCKETS;
+    fwrite(&header, sizeof(header), 1, f);
+
+    /* the ring wraps at most once */
+    start = first & traceMask;
+    if (start + n > traceMask + 1) {
+        fwrite(&traceRing[start], sizeof(DispatchTraceRecordRec),
+               traceMask + 1 - start, f);
+        n -= traceMask + 1 - start;
+        start = 0;
+    }
+    fwrite(&traceRing[start], sizeof(DispatchTraceRecordRec), n, f);
+    fwrite(traceHistogram, sizeof(traceHistogram), 1, f);
+}
+
+/*
+ * Write out what has been traced since the last dump and start over;
+ * the first call with tracing off only turns it on.
+ */
+void
+DispatchTraceDump(void)
+{
+    FILE *f = NULL;
+
+    if (!DispatchTraceEnabled) {
+        if (DispatchTraceInit())
+            ErrorF("Dispatch tracing enabled\n");
+        return;
+    }
+    if (DispatchTraceFile) {
+        f = Fopen(DispatchTraceFile, "w");
+        if (!f) {
+            ErrorF("Dispatch tracing: can't write %s\n", DispatchTraceFile);
+            return;
+        }
+    }
+    if (f && DispatchTraceBinary)
+        DispatchTraceBinaryDump(f);
+    else
+        DispatchTraceCSV(f);
+    if (f)
+        Fclose(f);
+    traceCount = 0;
+    memset(traceHistogram, 0, sizeof(traceHistogram));
+}
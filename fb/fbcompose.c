@@ -43,9 +43,6 @@
 
 #define SCANLINE_BUFFER_LENGTH 2048
 
-typedef FASTCALL void (*fetchProc) (const FbBits * bits, int x, int width,
-                                    CARD32 *buffer, miIndexedPtr indexed);
-
 /*
  * All of the fetch functions
  */
@@ -627,6 +624,11 @@ fbFetch_g1(const FbBits * bits, int x, int width, CARD32 *buffer,
 static fetchProc
 fetchProcForPicture(PicturePtr pict)
 {
+    fetchProc fetch = fbSimdFetchProc(pict->format);
+
+    if (fetch)
+        return fetch;
+
     switch (pict->format) {
     case PICT_a8r8g8b8:
         return fbFetch_a8r8g8b8;
@@ -1191,9 +1193,6 @@ fetchPixelProcForPicture(PicturePtr pict)
  * All the store functions
  */
 
-typedef FASTCALL void (*storeProc) (FbBits * bits, const CARD32 *values, int x,
-                                    int width, miIndexedPtr indexed);
-
 #define Splita(v)	CARD32	a = ((v) >> 24), r = ((v) >> 16) & 0xff, g = ((v) >> 8) & 0xff, b = (v) & 0xff
 #define Split(v)	CARD32	r = ((v) >> 16) & 0xff, g = ((v) >> 8) & 0xff, b = (v) & 0xff
 
@@ -1642,6 +1641,11 @@ fbStore_g1(FbBits * bits, const CARD32 *values, int x, int width,
 static storeProc
 storeProcForPicture(PicturePtr pict)
 {
+    storeProc store = fbSimdStoreProc(pict->format);
+
+    if (store)
+        return store;
+
     switch (pict->format) {
     case PICT_a8r8g8b8:
         return fbStore_a8r8g8b8;
@@ -2269,7 +2273,7 @@ fbCombineConjointXorU(CARD32 *dest, const CARD32 *src, int width)
     fbCombineConjointGeneralU(dest, src, width, CombineXor);
 }
 
-static const CombineFuncU fbCombineFuncU[] = {
+static CombineFuncU fbCombineFuncU[] = {
     fbCombineClear,
     fbCombineSrcU,
     NULL,                       /* CombineDst */
@@ -2936,7 +2940,7 @@ fbCombineConjointXorC(CARD32 *dest, CARD32 *src, CARD32 *mask, int width)
     fbCombineConjointGeneralC(dest, src, mask, width, CombineXor);
 }
 
-static const CombineFuncC fbCombineFuncC[] = {
+static CombineFuncC fbCombineFuncC[] = {
     fbCombineClearC,
     fbCombineSrcC,
     NULL,                       /* Dest */
@@ -2983,7 +2987,7 @@ static const CombineFuncC fbCombineFuncC[] = {
     fbCombineConjointXorC,
 };
 
-static const FbComposeFunctions composeFunctions = {
+static FbComposeFunctions composeFunctions = {
     fbCombineFuncU,
     fbCombineFuncC,
     fbCombineMaskU
@@ -3050,7 +3054,7 @@ static CARD32
 gradientPixel(const SourcePictPtr pGradient, xFixed_48_16 pos,
               unsigned int spread)
 {
-    int ipos = (pos * PICT_GRADIENT_STOPTABLE_SIZE - 1) >> 16;
+    int ipos = FbGradientIndex(pos);
 
     /* calculate the actual offset. */
     if (ipos < 0 || ipos >= PICT_GRADIENT_STOPTABLE_SIZE) {
@@ -3084,6 +3088,145 @@ gradientPixel(const SourcePictPtr pGradient, xFixed_48_16 pos,
     return pGradient->linear.colorTable[ipos];
 }
 
+/*
+ * Look up table positions with the spread applied, one loop per spread
+ * so the choice isn't made again for every pixel.  Conical gradients
+ * always wrap.
+ */
+static void
+fbGradientSpread(const SourcePictPtr pGradient, unsigned int spread,
+                 const int *ipos, int n, CARD32 *buffer)
+{
+    const CARD32 *table = pGradient->gradient.colorTable;
+
+    const int limit = PICT_GRADIENT_STOPTABLE_SIZE * 2 - 1;
+
+    int i, p;
+
+    if (pGradient->type == SourcePictTypeConical)
+        spread = RepeatNormal;
+
+    switch (spread) {
+    case RepeatNormal:
+        /* the table size is a power of two */
+        for (i = 0; i < n; i++)
+            buffer[i] = table[ipos[i] & (PICT_GRADIENT_STOPTABLE_SIZE - 1)];
+        break;
+    case RepeatReflect:
+        for (i = 0; i < n; i++) {
+            p = ipos[i];
+            if ((unsigned) p >= PICT_GRADIENT_STOPTABLE_SIZE) {
+                p = p % limit;
+                p = p < 0 ? limit + p : p;
+                p = p >= PICT_GRADIENT_STOPTABLE_SIZE ? limit - p : p;
+            }
+            buffer[i] = table[p];
+        }
+        break;
+    case RepeatPad:
+        for (i = 0; i < n; i++) {
+            p = ipos[i];
+            if (p < 0)
+                p = 0;
+            else if (p >= PICT_GRADIENT_STOPTABLE_SIZE)
+                p = PICT_GRADIENT_STOPTABLE_SIZE - 1;
+            buffer[i] = table[p];
+        }
+        break;
+    default:                   /* RepeatNone */
+        for (i = 0; i < n; i++) {
+            p = ipos[i];
+            buffer[i] = (unsigned) p < PICT_GRADIENT_STOPTABLE_SIZE ?
+                table[p] : 0;
+        }
+        break;
+    }
+}
+
+/*
+ * Radial gradient positions along an affine scanline.  Both b and the
+ * discriminant are polynomials in the pixel index, so they are stepped
+ * with forward differences and only the square root is left per pixel.
+ */
+static void
+fbRadialIndices(const SourcePictPtr pGradient, double rx, double ry,
+                double cx, double cy, int n, int *ipos)
+{
+    const PictRadialGradient *radial = &pGradient->radial;
+
+    double a4 = 4 * radial->a;
+
+    double inv2a = 1. / (2 * radial->a);
+
+    double b = 2 * (rx * radial->dx + ry * radial->dy);
+
+    double db = 2 * (cx * radial->dx + cy * radial->dy);
+
+    double det = b * b + a4 * (rx * rx + ry * ry);
+
+    double ddet = 2 * b * db + db * db +
+        a4 * (2 * rx * cx + cx * cx + 2 * ry * cy + cy * cy);
+
+    double d2 = 2 * (db * db + a4 * (cx * cx + cy * cy));
+
+    int i;
+
+    for (i = 0; i < n; i++) {
+        double s = (-b + sqrt(det > 0 ? det : 0)) * inv2a;
+
+        ipos[i] = FbGradientIndex((xFixed_48_16) ((s * radial->m +
+                                                   radial->b) * 65536));
+        b += db;
+        det += ddet;
+        ddet += d2;
+    }
+}
+
+static void
+fbConicalIndices(const SourcePictPtr pGradient, double rx, double ry,
+                 double cx, double cy, int n, int *ipos)
+{
+    double a = pGradient->conical.angle / (180. * 65536);
+
+    int i;
+
+    for (i = 0; i < n; i++) {
+        double angle = atan2(ry, rx) + a;
+
+        ipos[i] = FbGradientIndex((xFixed_48_16) (angle *
+                                                  (65536. / (2 * M_PI))));
+        rx += cx;
+        ry += cy;
+    }
+}
+
+static GradientIndexProc fbRadialIndex = fbRadialIndices;
+
+static GradientIndexProc fbConicalIndex = fbConicalIndices;
+
+/* Gradient positions are worked out this many pixels at a time */
+#define GRADIENT_CHUNK 256
+
+static void
+fbFetchGradientAffine(PicturePtr pict, GradientIndexProc indices,
+                      double rx, double ry, double cx, double cy,
+                      int width, CARD32 *buffer)
+{
+    int ipos[GRADIENT_CHUNK];
+
+    while (width) {
+        int n = min(width, GRADIENT_CHUNK);
+
+        (*indices) (pict->pSourcePict, rx, ry, cx, cy, n, ipos);
+        fbGradientSpread(pict->pSourcePict, pict->repeatType, ipos, n,
+                         buffer);
+        rx += n * cx;
+        ry += n * cy;
+        buffer += n;
+        width -= n;
+    }
+}
+
 static void
 fbFetchSourcePict(PicturePtr pict, int x, int y, int width, CARD32 *buffer)
 {
@@ -3145,8 +3288,17 @@ fbFetchSourcePict(PicturePtr pict, int x, int y, int width, CARD32 *buffer)
                 inc = (a * unit.vector[0] + b * unit.vector[1]) >> 16;
             }
             while (buffer < end) {
-                *buffer++ = gradientPixel(pGradient, t, pict->repeatType);
-                t += inc;
+                int ipos[GRADIENT_CHUNK];
+
+                int i, n = min(end - buffer, GRADIENT_CHUNK);
+
+                for (i = 0; i < n; i++) {
+                    ipos[i] = FbGradientIndex(t);
+                    t += inc;
+                }
+                fbGradientSpread(pGradient, pict->repeatType, ipos, n,
+                                 buffer);
+                buffer += n;
             }
         }
         else {
@@ -3211,28 +3363,8 @@ fbFetchSourcePict(PicturePtr pict, int x, int y, int width, CARD32 *buffer)
             if (affine) {
                 rx -= pGradient->radial.fx;
                 ry -= pGradient->radial.fy;
-
-                while (buffer < end) {
-                    double b =
-                        2 * (rx * pGradient->radial.dx +
-                             ry * pGradient->radial.dy);
-                    double c = -(rx * rx + ry * ry);
-
-                    double det = (b * b) - (4 * pGradient->radial.a * c);
-
-                    double s = (-b + sqrt(det)) / (2. * pGradient->radial.a);
-
-                    *buffer = gradientPixel(pGradient,
-                                            (xFixed_48_16) ((s *
-                                                             pGradient->radial.
-                                                             m +
-                                                             pGradient->radial.
-                                                             b) * 65536),
-                                            pict->repeatType);
-                    ++buffer;
-                    rx += cx;
-                    ry += cy;
-                }
+                fbFetchGradientAffine(pict, fbRadialIndex, rx, ry, cx, cy,
+                                      width, buffer);
             }
             else {
                 while (buffer < end) {
@@ -3275,19 +3407,8 @@ fbFetchSourcePict(PicturePtr pict, int x, int y, int width, CARD32 *buffer)
             if (affine) {
                 rx -= pGradient->conical.center.x / 65536.;
                 ry -= pGradient->conical.center.y / 65536.;
-
-                while (buffer < end) {
-                    double angle = atan2(ry, rx) + a;
-
-                    *buffer =
-                        gradientPixel(pGradient,
-                                      (xFixed_48_16) (angle *
-                                                      (65536. / (2 * M_PI))),
-                                      pict->repeatType);
-                    ++buffer;
-                    rx += cx;
-                    ry += cy;
-                }
+                fbFetchGradientAffine(pict, fbConicalIndex, rx, ry, cx, cy,
+                                      width, buffer);
             }
             else {
 
@@ -3319,6 +3440,350 @@ fbFetchSourcePict(PicturePtr pict, int x, int y, int width, CARD32 *buffer)
     }
 }
 
+/*
+ * Affine transforms don't need the per-pixel division: the sample point
+ * moves by a constant 16.16 step along the destination scanline.  When
+ * the transform is a pure scale (no rotation or shear) every sample on
+ * the scanline also comes from the same source row, or pair of rows for
+ * bilinear, and those rows are converted once with the scanline fetcher
+ * instead of going through fetchPixelProc per sample.  All of these
+ * produce exactly what the general code below does; they only handle the
+ * single rectangle clip case.
+ */
+
+/* Longest run of source pixels converted for a scaled scanline */
+#define TRANSFORM_ROW_LENGTH	2048
+
+static INLINE CARD32
+fbBilinearInterpolate(CARD32 tl, CARD32 tr, CARD32 bl, CARD32 br,
+                      int distx, int disty)
+{
+    int idistx = 256 - distx;
+
+    int idisty = 256 - disty;
+
+    CARD32 ft, fb, r;
+
+    ft = FbGet8(tl, 0) * idistx + FbGet8(tr, 0) * distx;
+    fb = FbGet8(bl, 0) * idistx + FbGet8(br, 0) * distx;
+    r = (((ft * idisty + fb * disty) >> 16) & 0xff);
+    ft = FbGet8(tl, 8) * idistx + FbGet8(tr, 8) * distx;
+    fb = FbGet8(bl, 8) * idistx + FbGet8(br, 8) * distx;
+    r |= (((ft * idisty + fb * disty) >> 8) & 0xff00);
+    ft = FbGet8(tl, 16) * idistx + FbGet8(tr, 16) * distx;
+    fb = FbGet8(bl, 16) * idistx + FbGet8(br, 16) * distx;
+    r |= (((ft * idisty + fb * disty)) & 0xff0000);
+    ft = FbGet8(tl, 24) * idistx + FbGet8(tr, 24) * distx;
+    fb = FbGet8(bl, 24) * idistx + FbGet8(br, 24) * distx;
+    r |= (((ft * idisty + fb * disty) << 8) & 0xff000000);
+    return r;
+}
+
+/*
+ * Convert source pixels x .. x + n - 1 of row y into row.  With clip set
+ * anything outside the clip box reads as zero, otherwise the whole span
+ * must lie inside the drawable.
+ */
+static void
+fbFetchSourceRow(PicturePtr pict, FbBits * bits, FbStride stride,
+                 int x, int y, int n, CARD32 *row, Bool clip)
+{
+    int dx = pict->pDrawable->x;
+
+    int dy = pict->pDrawable->y;
+
+    int x1 = x, x2 = x + n;
+
+    if (clip) {
+        BoxPtr pBox = &pict->pCompositeClip->extents;
+
+        x1 = max(x1, pBox->x1 - dx);
+        x2 = min(x2, pBox->x2 - dx);
+        if (y < pBox->y1 - dy || y >= pBox->y2 - dy || x1 >= x2) {
+            memset(row, 0, n * sizeof(CARD32));
+            return;
+        }
+    }
+    memset(row, 0, (x1 - x) * sizeof(CARD32));
+    fetchProcForPicture(pict) (bits + (y + dy) * stride, x1 + dx, x2 - x1,
+                               row + (x1 - x),
+                               (miIndexedPtr) pict->pFormat->index.
+                               devPrivate);
+    memset(row + (x2 - x), 0, (x + n - x2) * sizeof(CARD32));
+}
+
+/*
+ * Work out the source columns touched by a scaled scanline, returning
+ * FALSE when it's cheaper to sample the pixels one by one.  extra is the
+ * number of columns the filter reads past the sample point.
+ */
+static Bool
+fbScaledSpan(xFixed vx, xFixed ux, int width, int extra, int *x, int *n)
+{
+    xFixed_48_16 last = (xFixed_48_16) vx + (xFixed_48_16) ux * (width - 1);
+
+    xFixed_48_16 first = vx;
+
+    if (last < first) {
+        first = last;
+        last = vx;
+    }
+    if ((xFixed) first != first || (xFixed) last != last)
+        return FALSE;
+    *x = (xFixed) first >> 16;
+    *n = ((xFixed) last >> 16) - *x + 1 + extra;
+    return *n <= TRANSFORM_ROW_LENGTH && *n <= 4 * width + extra;
+}
+
+static void
+fbFetchAffineNearest(PicturePtr pict, FbBits * bits, FbStride stride,
+                     PictVector * v, PictVector * unit, int width,
+                     CARD32 *buffer)
+{
+    int x, y, i;
+
+    int dx = pict->pDrawable->x;
+
+    int dy = pict->pDrawable->y;
+
+    int w = pict->pDrawable->width;
+
+    int h = pict->pDrawable->height;
+
+    fetchPixelProc fetch = fetchPixelProcForPicture(pict);
+
+    miIndexedPtr indexed = (miIndexedPtr) pict->pFormat->index.devPrivate;
+
+    xFixed vx = v->vector[0], vy = v->vector[1];
+
+    xFixed ux = unit->vector[0], uy = unit->vector[1];
+
+    if (pict->repeatType == RepeatNormal) {
+        for (i = 0; i < width; ++i) {
+            x = MOD(vx >> 16, w);
+            y = MOD(vy >> 16, h);
+            buffer[i] = fetch(bits + (y + dy) * stride, x + dx, indexed);
+            vx += ux;
+            vy += uy;
+        }
+    }
+    else {
+        BoxPtr pBox = &pict->pCompositeClip->extents;
+
+        int x1 = pBox->x1 - dx, x2 = pBox->x2 - dx;
+
+        int y1 = pBox->y1 - dy, y2 = pBox->y2 - dy;
+
+        for (i = 0; i < width; ++i) {
+            x = vx >> 16;
+            y = vy >> 16;
+            buffer[i] = ((x < x1) | (x >= x2) | (y < y1) | (y >= y2))
+                ? 0 : fetch(bits + (y + dy) * stride, x + dx, indexed);
+            vx += ux;
+            vy += uy;
+        }
+    }
+}
+
+static Bool
+fbFetchScaledNearest(PicturePtr pict, FbBits * bits, FbStride stride,
+                     PictVector * v, PictVector * unit, int width,
+                     CARD32 *buffer)
+{
+    CARD32 row[TRANSFORM_ROW_LENGTH];
+
+    xFixed vx = v->vector[0], ux = unit->vector[0];
+
+    int x, n, i;
+
+    int y = v->vector[1] >> 16;
+
+    if (pict->repeatType == RepeatNormal) {
+        int w = pict->pDrawable->width;
+
+        xFixed wrap = IntToxFixed(w);
+
+        if (w > TRANSFORM_ROW_LENGTH || w > 4 * width)
+            return FALSE;
+        /*
+         * Keep the sample point inside the first tile; moving it by a
+         * whole tile doesn't change which column MOD picks.
+         */
+        vx = IntToxFixed(MOD(vx >> 16, w)) + (vx & 0xffff);
+        ux %= wrap;
+        fbFetchSourceRow(pict, bits, stride, 0,
+                         MOD(y, pict->pDrawable->height), w, row, FALSE);
+        for (i = 0; i < width; ++i) {
+            buffer[i] = row[vx >> 16];
+            vx += ux;
+            if (vx >= wrap)
+                vx -= wrap;
+            else if (vx < 0)
+                vx += wrap;
+        }
+    }
+    else {
+        if (!fbScaledSpan(vx, ux, width, 0, &x, &n))
+            return FALSE;
+        fbFetchSourceRow(pict, bits, stride, x, y, n, row, TRUE);
+        for (i = 0; i < width; ++i) {
+            buffer[i] = row[(vx >> 16) - x];
+            vx += ux;
+        }
+    }
+    return TRUE;
+}
+
+static void
+fbFetchAffineBilinear(PicturePtr pict, FbBits * bits, FbStride stride,
+                      PictVector * v, PictVector * unit, int width,
+                      CARD32 *buffer)
+{
+    int i;
+
+    int dx = pict->pDrawable->x;
+
+    int dy = pict->pDrawable->y;
+
+    int w = pict->pDrawable->width;
+
+    int h = pict->pDrawable->height;
+
+    fetchPixelProc fetch = fetchPixelProcForPicture(pict);
+
+    miIndexedPtr indexed = (miIndexedPtr) pict->pFormat->index.devPrivate;
+
+    xFixed vx = v->vector[0], vy = v->vector[1];
+
+    xFixed ux = unit->vector[0], uy = unit->vector[1];
+
+    if (pict->repeatType == RepeatNormal) {
+        for (i = 0; i < width; ++i) {
+            int x1 = vx >> 16, y1 = vy >> 16;
+
+            int x2 = MOD(x1 + 1, w), y2 = MOD(y1 + 1, h);
+
+            FbBits *b1, *b2;
+
+            x1 = MOD(x1, w);
+            y1 = MOD(y1, h);
+            b1 = bits + (y1 + dy) * stride;
+            b2 = bits + (y2 + dy) * stride;
+            buffer[i] = fbBilinearInterpolate(fetch(b1, x1 + dx, indexed),
+                                              fetch(b1, x2 + dx, indexed),
+                                              fetch(b2, x1 + dx, indexed),
+                                              fetch(b2, x2 + dx, indexed),
+                                              (vx >> 8) & 0xff,
+                                              (vy >> 8) & 0xff);
+            vx += ux;
+            vy += uy;
+        }
+    }
+    else {
+        BoxPtr pBox = &pict->pCompositeClip->extents;
+
+        int bx1 = pBox->x1 - dx, bx2 = pBox->x2 - dx;
+
+        int by1 = pBox->y1 - dy, by2 = pBox->y2 - dy;
+
+        for (i = 0; i < width; ++i) {
+            int x1 = vx >> 16, y1 = vy >> 16;
+
+            Bool x1_out = (x1 < bx1) | (x1 >= bx2);
+
+            Bool x2_out = (x1 + 1 < bx1) | (x1 + 1 >= bx2);
+
+            Bool y1_out = (y1 < by1) | (y1 >= by2);
+
+            Bool y2_out = (y1 + 1 < by1) | (y1 + 1 >= by2);
+
+            FbBits *b = bits + (y1 + dy) * stride;
+
+            CARD32 tl, tr, bl, br;
+
+            tl = x1_out | y1_out ? 0 : fetch(b, x1 + dx, indexed);
+            tr = x2_out | y1_out ? 0 : fetch(b, x1 + dx + 1, indexed);
+            b += stride;
+            bl = x1_out | y2_out ? 0 : fetch(b, x1 + dx, indexed);
+            br = x2_out | y2_out ? 0 : fetch(b, x1 + dx + 1, indexed);
+            buffer[i] = fbBilinearInterpolate(tl, tr, bl, br,
+                                              (vx >> 8) & 0xff,
+                                              (vy >> 8) & 0xff);
+            vx += ux;
+            vy += uy;
+        }
+    }
+}
+
+static Bool
+fbFetchScaledBilinear(PicturePtr pict, FbBits * bits, FbStride stride,
+                      PictVector * v, PictVector * unit, int width,
+                      CARD32 *buffer)
+{
+    CARD32 top[TRANSFORM_ROW_LENGTH], bottom[TRANSFORM_ROW_LENGTH];
+
+    CARD32 *row2 = bottom;
+
+    xFixed vx = v->vector[0], ux = unit->vector[0];
+
+    int x, n, i;
+
+    int y = v->vector[1] >> 16;
+
+    int disty = (v->vector[1] >> 8) & 0xff;
+
+    /* with no weight on the lower row its contents don't matter */
+    if (!disty)
+        row2 = top;
+
+    if (pict->repeatType == RepeatNormal) {
+        int w = pict->pDrawable->width;
+
+        int h = pict->pDrawable->height;
+
+        xFixed wrap = IntToxFixed(w);
+
+        if (w > TRANSFORM_ROW_LENGTH || w > 4 * width)
+            return FALSE;
+        vx = IntToxFixed(MOD(vx >> 16, w)) + (vx & 0xffff);
+        ux %= wrap;
+        fbFetchSourceRow(pict, bits, stride, 0, MOD(y, h), w, top, FALSE);
+        if (disty)
+            fbFetchSourceRow(pict, bits, stride, 0, MOD(y + 1, h), w, bottom,
+                             FALSE);
+        for (i = 0; i < width; ++i) {
+            int x1 = vx >> 16;
+
+            int x2 = x1 + 1 == w ? 0 : x1 + 1;
+
+            buffer[i] = fbBilinearInterpolate(top[x1], top[x2],
+                                              row2[x1], row2[x2],
+                                              (vx >> 8) & 0xff, disty);
+            vx += ux;
+            if (vx >= wrap)
+                vx -= wrap;
+            else if (vx < 0)
+                vx += wrap;
+        }
+    }
+    else {
+        if (!fbScaledSpan(vx, ux, width, 1, &x, &n))
+            return FALSE;
+        fbFetchSourceRow(pict, bits, stride, x, y, n, top, TRUE);
+        if (disty)
+            fbFetchSourceRow(pict, bits, stride, x, y + 1, n, bottom, TRUE);
+        for (i = 0; i < width; ++i) {
+            int x1 = (vx >> 16) - x;
+
+            buffer[i] = fbBilinearInterpolate(top[x1], top[x1 + 1],
+                                              row2[x1], row2[x1 + 1],
+                                              (vx >> 8) & 0xff, disty);
+            vx += ux;
+        }
+    }
+    return TRUE;
+}
+
 static void
 fbFetchTransformed(PicturePtr pict, int x, int y, int width, CARD32 *buffer)
 {
@@ -3374,6 +3839,14 @@ fbFetchTransformed(PicturePtr pict, int x, int y, int width, CARD32 *buffer)
     }
 
     if (pict->filter == PictFilterNearest) {
+        if (affine && REGION_NUM_RECTS(pict->pCompositeClip) == 1) {
+            if (unit.vector[1] ||
+                !fbFetchScaledNearest(pict, bits, stride, &v, &unit,
+                                      width, buffer))
+                fbFetchAffineNearest(pict, bits, stride, &v, &unit,
+                                     width, buffer);
+            return;
+        }
         if (pict->repeatType == RepeatNormal) {
             if (REGION_NUM_RECTS(pict->pCompositeClip) == 1) {
                 for (i = 0; i < width; ++i) {
@@ -3496,6 +3969,14 @@ fbFetchTransformed(PicturePtr pict, int x, int y, int width, CARD32 *buffer)
         unit.vector[0] -= unit.vector[2] / 2;
         unit.vector[1] -= unit.vector[2] / 2;
 
+        if (affine && REGION_NUM_RECTS(pict->pCompositeClip) == 1) {
+            if (unit.vector[1] ||
+                !fbFetchScaledBilinear(pict, bits, stride, &v, &unit,
+                                       width, buffer))
+                fbFetchAffineBilinear(pict, bits, stride, &v, &unit,
+                                      width, buffer);
+            return;
+        }
         if (pict->repeatType == RepeatNormal) {
             if (REGION_NUM_RECTS(pict->pCompositeClip) == 1) {
                 for (i = 0; i < width; ++i) {
@@ -3923,7 +4404,7 @@ fbFetchExternalAlpha(PicturePtr pict, int x, int y, int width, CARD32 *buffer)
         return;
     }
     if (width > SCANLINE_BUFFER_LENGTH)
-        alpha_buffer = malloc(width * sizeof(CARD32));
+        alpha_buffer = ScratchAlloc(width * sizeof(CARD32));
 
     fbFetchTransformed(pict, x, y, width, buffer);
     fbFetchTransformed(pict->alphaMap, x - pict->alphaOrigin.x,
@@ -3938,7 +4419,7 @@ fbFetchExternalAlpha(PicturePtr pict, int x, int y, int width, CARD32 *buffer)
     }
 
     if (alpha_buffer != _alpha_buffer)
-        free(alpha_buffer);
+        ScratchFree(alpha_buffer);
 }
 
 static void
@@ -4214,7 +4695,7 @@ fbCompositeGeneral(CARD8 op,
     compose_data.mask = pMask;
     compose_data.dest = pDst;
     if (width > SCANLINE_BUFFER_LENGTH)
-        scanline_buffer = malloc(width * 3 * sizeof(CARD32));
+        scanline_buffer = ScratchAlloc(width * 3 * sizeof(CARD32));
 
     n = REGION_NUM_RECTS(&region);
     pbox = REGION_RECTS(&region);
@@ -4279,6 +4760,19 @@ fbCompositeGeneral(CARD8 op,
     REGION_UNINIT(&region);
 
     if (scanline_buffer != _scanline_buffer)
-        free(scanline_buffer);
+        ScratchFree(scanline_buffer);
 }
 
+void
+fbComposeInit(void)
+{
+    static Bool initialized;
+
+    if (initialized)
+        return;
+    initialized = TRUE;
+    fbSimdCombineInit(fbCombineFuncU, fbCombineFuncC,
+                      &composeFunctions.combineMaskU);
+    fbSimdConvertInit();
+    fbSimdGradientInit(&fbRadialIndex, &fbConicalIndex);
+}
@@ -202,7 +202,7 @@ fbCopyNto1(DrawablePtr pSrcDrawable,
             height = pbox->y2 - pbox->y1;
 
             tmpStride = ((width + FB_STIP_MASK) >> FB_STIP_SHIFT);
-            tmp = malloc(tmpStride * height * sizeof(FbStip));
+            tmp = ScratchAlloc(tmpStride * height * sizeof(FbStip));
             if (!tmp)
                 return;
 
@@ -234,7 +234,7 @@ fbCopyNto1(DrawablePtr pSrcDrawable,
                      width * dstBpp,
                      height,
                      pPriv->and, pPriv->xor, pPriv->bgand, pPriv->bgxor);
-            free(tmp);
+            ScratchFree(tmp);
         }
         pbox++;
     }
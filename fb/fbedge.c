@@ -284,3 +284,66 @@ fbRasterizeEdges(FbBits * buf,
     }
 }
 
+/*
+ * Add one run of coverage from the sweep rasterizer into an a1, a4 or a8
+ * picture, saturating like the edge walkers above.
+ */
+void
+fbRasterizeSpan(pointer closure, int y, int x, int len, CARD8 *coverage)
+{
+    FbSpanBitsPtr dst = (FbSpanBitsPtr) closure;
+
+    FbBits *line = dst->bits + y * dst->stride;
+
+    int i;
+
+    switch (dst->bpp) {
+    case 1:
+        for (i = 0; i < len;) {
+            FbBits *a, startmask, endmask;
+
+            int nmiddle, start, xi;
+
+            if (!coverage[i]) {
+                i++;
+                continue;
+            }
+            start = i;
+            while (i < len && coverage[i])
+                i++;
+            xi = x + start;
+            a = line + (xi >> FB_SHIFT);
+            FbMaskBits(xi & FB_MASK, i - start, startmask, nmiddle, endmask);
+            if (startmask)
+                *a++ |= startmask;
+            while (nmiddle--)
+                *a++ = FB_ALLONES;
+            if (endmask)
+                *a |= endmask;
+        }
+        break;
+    case 4:
+        for (i = 0; i < len; i++) {
+            CARD8 *ap = (CARD8 *) line + ((x + i) >> 1);
+
+            int o = (x + i) & 1;
+
+            CARD8 a = coverage[i] + Get4(*ap, o);
+
+            *ap = Put4(*ap, o, a | (0 - (a >> 4)));
+        }
+        break;
+    case 8:
+        {
+            CARD8 *ap = (CARD8 *) line + x;
+
+            for (i = 0; i < len; i++) {
+                if (coverage[i] == 0xff)
+                    ap[i] = 0xff;
+                else if (coverage[i])
+                    ap[i] = clip255(ap[i] + coverage[i]);
+            }
+        }
+        break;
+    }
+}
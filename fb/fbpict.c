@@ -800,6 +800,506 @@ fbCompositeSolidMask_nx1xn(CARD8 op,
              dstBpp, width * dstBpp, height, 0x0, src, FB_ALLONES, 0x0);
 }
 
+void
+fbCompositeSrc_8888x8x0565(CARD8 op,
+                           PicturePtr pSrc,
+                           PicturePtr pMask,
+                           PicturePtr pDst,
+                           INT16 xSrc,
+                           INT16 ySrc,
+                           INT16 xMask,
+                           INT16 yMask,
+                           INT16 xDst, INT16 yDst, CARD16 width, CARD16 height)
+{
+    CARD16 *dstLine, *dst;
+
+    CARD32 *srcLine, *src, s, d;
+
+    CARD8 *maskLine, *mask, m;
+
+    FbStride dstStride, srcStride, maskStride;
+
+    CARD8 a;
+
+    CARD16 w;
+
+    fbComposeGetStart(pSrc, xSrc, ySrc, CARD32, srcStride, srcLine, 1);
+    fbComposeGetStart(pMask, xMask, yMask, CARD8, maskStride, maskLine, 1);
+    fbComposeGetStart(pDst, xDst, yDst, CARD16, dstStride, dstLine, 1);
+
+    while (height--) {
+        dst = dstLine;
+        dstLine += dstStride;
+        src = srcLine;
+        srcLine += srcStride;
+        mask = maskLine;
+        maskLine += maskStride;
+        w = width;
+
+        while (w--) {
+            s = *src++;
+            m = *mask++;
+            if (m) {
+                if (m != 0xff)
+                    s = fbIn(s, m);
+                a = s >> 24;
+                if (a) {
+                    if (a == 0xff)
+                        d = s;
+                    else {
+                        d = *dst;
+                        d = fbOver24(s, cvt0565to8888(d));
+                    }
+                    *dst = cvt8888to0565(d);
+                }
+            }
+            dst++;
+        }
+    }
+}
+
+void
+fbCompositeSrcSrc_0565x8888(CARD8 op,
+                            PicturePtr pSrc,
+                            PicturePtr pMask,
+                            PicturePtr pDst,
+                            INT16 xSrc,
+                            INT16 ySrc,
+                            INT16 xMask,
+                            INT16 yMask,
+                            INT16 xDst, INT16 yDst, CARD16 width, CARD16 height)
+{
+    CARD32 *dstLine, *dst;
+
+    CARD16 *srcLine, *src, s;
+
+    FbStride dstStride, srcStride;
+
+    CARD16 w;
+
+    fbComposeGetStart(pSrc, xSrc, ySrc, CARD16, srcStride, srcLine, 1);
+    fbComposeGetStart(pDst, xDst, yDst, CARD32, dstStride, dstLine, 1);
+
+    while (height--) {
+        dst = dstLine;
+        dstLine += dstStride;
+        src = srcLine;
+        srcLine += srcStride;
+        w = width;
+
+        while (w--) {
+            s = *src++;
+            *dst++ = cvt0565to8888(s) | 0xff000000;
+        }
+    }
+}
+
+void
+fbCompositeSolidMaskAdd_nx8x8000(CARD8 op,
+                                 PicturePtr pSrc,
+                                 PicturePtr pMask,
+                                 PicturePtr pDst,
+                                 INT16 xSrc,
+                                 INT16 ySrc,
+                                 INT16 xMask,
+                                 INT16 yMask,
+                                 INT16 xDst,
+                                 INT16 yDst, CARD16 width, CARD16 height)
+{
+    CARD8 *dstLine, *dst;
+
+    CARD8 *maskLine, *mask;
+
+    FbStride dstStride, maskStride;
+
+    CARD32 src;
+
+    CARD8 srca;
+
+    CARD16 w, m, t;
+
+    fbComposeGetSolid(pSrc, src, pDst->format);
+
+    srca = PICT_FORMAT_A(pSrc->format) ? src >> 24 : 0xff;
+    if (srca == 0)
+        return;
+
+    fbComposeGetStart(pMask, xMask, yMask, CARD8, maskStride, maskLine, 1);
+    fbComposeGetStart(pDst, xDst, yDst, CARD8, dstStride, dstLine, 1);
+
+    while (height--) {
+        dst = dstLine;
+        dstLine += dstStride;
+        mask = maskLine;
+        maskLine += maskStride;
+        w = width;
+
+        while (w--) {
+            m = *mask++;
+            if (m) {
+                if (srca != 0xff)
+                    m = FbIntMult(m, srca, t);
+                t = *dst + m;
+                *dst = t | (0 - (t >> 8));
+            }
+            dst++;
+        }
+    }
+}
+
+/*
+ * Solid sources without a mask: opaque colours (and any colour for Src)
+ * are plain fills, anything else is blended in place.
+ */
+void
+fbCompositeSolidFill(CARD8 op,
+                     PicturePtr pSrc,
+                     PicturePtr pMask,
+                     PicturePtr pDst,
+                     INT16 xSrc,
+                     INT16 ySrc,
+                     INT16 xMask,
+                     INT16 yMask,
+                     INT16 xDst, INT16 yDst, CARD16 width, CARD16 height)
+{
+    FbBits *dstBits;
+
+    FbStride dstStride;
+
+    int dstBpp;
+
+    int dstXoff, dstYoff;
+
+    CARD32 src;
+
+    fbComposeGetSolid(pSrc, src, pDst->format);
+
+    if (!PICT_FORMAT_A(pSrc->format))
+        src |= 0xff000000;
+
+    fbGetDrawable(pDst->pDrawable, dstBits, dstStride, dstBpp, dstXoff,
+                  dstYoff);
+
+    switch (pDst->format) {
+    case PICT_a8:
+        src >>= 24;
+        break;
+    case PICT_r5g6b5:
+    case PICT_b5g6r5:
+        src = cvt8888to0565(src);
+        break;
+    default:
+        break;
+    }
+    src &= FbFullMask(pDst->pDrawable->depth);
+
+    fbSolid(dstBits + dstStride * (yDst + dstYoff),
+            dstStride,
+            (xDst + dstXoff) * dstBpp,
+            dstBpp, width * dstBpp, height, 0, fbReplicatePixel(src, dstBpp));
+}
+
+void
+fbCompositeSolid_nx8888(CARD8 op,
+                        PicturePtr pSrc,
+                        PicturePtr pMask,
+                        PicturePtr pDst,
+                        INT16 xSrc,
+                        INT16 ySrc,
+                        INT16 xMask,
+                        INT16 yMask,
+                        INT16 xDst, INT16 yDst, CARD16 width, CARD16 height)
+{
+    CARD32 src, srca;
+
+    CARD32 *dstLine, *dst, dstMask;
+
+    FbStride dstStride;
+
+    CARD16 w;
+
+    fbComposeGetSolid(pSrc, src, pDst->format);
+
+    srca = PICT_FORMAT_A(pSrc->format) ? src >> 24 : 0xff;
+    if (srca == 0xff) {
+        fbCompositeSolidFill(op, pSrc, pMask, pDst, xSrc, ySrc,
+                             xMask, yMask, xDst, yDst, width, height);
+        return;
+    }
+    if (src == 0)
+        return;
+
+    dstMask = FbFullMask(pDst->pDrawable->depth);
+    fbComposeGetStart(pDst, xDst, yDst, CARD32, dstStride, dstLine, 1);
+
+    while (height--) {
+        dst = dstLine;
+        dstLine += dstStride;
+        w = width;
+
+        while (w--) {
+            *dst = fbOver(src, *dst) & dstMask;
+            dst++;
+        }
+    }
+}
+
+void
+fbCompositeSolid_nx0565(CARD8 op,
+                        PicturePtr pSrc,
+                        PicturePtr pMask,
+                        PicturePtr pDst,
+                        INT16 xSrc,
+                        INT16 ySrc,
+                        INT16 xMask,
+                        INT16 yMask,
+                        INT16 xDst, INT16 yDst, CARD16 width, CARD16 height)
+{
+    CARD32 src, srca;
+
+    CARD16 *dstLine, *dst;
+
+    FbStride dstStride;
+
+    CARD16 w;
+
+    fbComposeGetSolid(pSrc, src, pDst->format);
+
+    srca = PICT_FORMAT_A(pSrc->format) ? src >> 24 : 0xff;
+    if (srca == 0xff) {
+        fbCompositeSolidFill(op, pSrc, pMask, pDst, xSrc, ySrc,
+                             xMask, yMask, xDst, yDst, width, height);
+        return;
+    }
+    if (src == 0)
+        return;
+
+    fbComposeGetStart(pDst, xDst, yDst, CARD16, dstStride, dstLine, 1);
+
+    while (height--) {
+        dst = dstLine;
+        dstLine += dstStride;
+        w = width;
+
+        while (w--) {
+            *dst = cvt8888to0565(fbOver24(src, cvt0565to8888(*dst)));
+            dst++;
+        }
+    }
+}
+
+/*
+ * Fast path table.
+ *
+ * fbComposite looks up (op, source, mask, destination) here before
+ * falling back to fbCompositeGeneral.  A solid source is matched as
+ * FbFormatSolid whatever its real format, and no mask as FbFormatNone.
+ * Lookups are remembered in a small cache, so the table itself can stay
+ * an unordered list; add new paths anywhere.
+ */
+
+#define FbFormatNone	0
+#define FbFormatSolid	PICT_FORMAT(0, PICT_TYPE_A, 0, 0, 0, 0)
+
+/* the mask must have component alpha; RGB masks must not otherwise */
+#define FbPathComponentAlpha	(1 << 0)
+/* a normally repeating source is fine, fbComposite tiles it */
+#define FbPathSrcRepeat		(1 << 1)
+
+typedef struct _FbFastPath {
+    CARD8 op;
+    CARD32 src;
+    CARD32 mask;
+    CARD32 dst;
+    CARD32 flags;
+    CompositeFunc func;
+} FbFastPathRec, *FbFastPathPtr;
+
+static const FbFastPathRec fbFastPaths[] = {
+    {PictOpOver, FbFormatSolid, PICT_a8, PICT_r5g6b5, 0,
+     fbCompositeSolidMask_nx8x0565},
+    {PictOpOver, FbFormatSolid, PICT_a8, PICT_b5g6r5, 0,
+     fbCompositeSolidMask_nx8x0565},
+    {PictOpOver, FbFormatSolid, PICT_a8, PICT_r8g8b8, 0,
+     fbCompositeSolidMask_nx8x0888},
+    {PictOpOver, FbFormatSolid, PICT_a8, PICT_b8g8r8, 0,
+     fbCompositeSolidMask_nx8x0888},
+    {PictOpOver, FbFormatSolid, PICT_a8, PICT_a8r8g8b8, 0,
+     fbCompositeSolidMask_nx8x8888},
+    {PictOpOver, FbFormatSolid, PICT_a8, PICT_x8r8g8b8, 0,
+     fbCompositeSolidMask_nx8x8888},
+    {PictOpOver, FbFormatSolid, PICT_a8, PICT_a8b8g8r8, 0,
+     fbCompositeSolidMask_nx8x8888},
+    {PictOpOver, FbFormatSolid, PICT_a8, PICT_x8b8g8r8, 0,
+     fbCompositeSolidMask_nx8x8888},
+    {PictOpOver, FbFormatSolid, PICT_a8r8g8b8, PICT_a8r8g8b8,
+     FbPathComponentAlpha, fbCompositeSolidMask_nx8888x8888C},
+    {PictOpOver, FbFormatSolid, PICT_a8r8g8b8, PICT_x8r8g8b8,
+     FbPathComponentAlpha, fbCompositeSolidMask_nx8888x8888C},
+    {PictOpOver, FbFormatSolid, PICT_a8r8g8b8, PICT_r5g6b5,
+     FbPathComponentAlpha, fbCompositeSolidMask_nx8888x0565C},
+    {PictOpOver, FbFormatSolid, PICT_a8b8g8r8, PICT_a8b8g8r8,
+     FbPathComponentAlpha, fbCompositeSolidMask_nx8888x8888C},
+    {PictOpOver, FbFormatSolid, PICT_a8b8g8r8, PICT_x8b8g8r8,
+     FbPathComponentAlpha, fbCompositeSolidMask_nx8888x8888C},
+    {PictOpOver, FbFormatSolid, PICT_a8b8g8r8, PICT_b5g6r5,
+     FbPathComponentAlpha, fbCompositeSolidMask_nx8888x0565C},
+    {PictOpOver, FbFormatSolid, PICT_a1, PICT_r5g6b5, 0,
+     fbCompositeSolidMask_nx1xn},
+    {PictOpOver, FbFormatSolid, PICT_a1, PICT_b5g6r5, 0,
+     fbCompositeSolidMask_nx1xn},
+    {PictOpOver, FbFormatSolid, PICT_a1, PICT_r8g8b8, 0,
+     fbCompositeSolidMask_nx1xn},
+    {PictOpOver, FbFormatSolid, PICT_a1, PICT_b8g8r8, 0,
+     fbCompositeSolidMask_nx1xn},
+    {PictOpOver, FbFormatSolid, PICT_a1, PICT_a8r8g8b8, 0,
+     fbCompositeSolidMask_nx1xn},
+    {PictOpOver, FbFormatSolid, PICT_a1, PICT_x8r8g8b8, 0,
+     fbCompositeSolidMask_nx1xn},
+    {PictOpOver, FbFormatSolid, PICT_a1, PICT_a8b8g8r8, 0,
+     fbCompositeSolidMask_nx1xn},
+    {PictOpOver, FbFormatSolid, PICT_a1, PICT_x8b8g8r8, 0,
+     fbCompositeSolidMask_nx1xn},
+
+    {PictOpOver, PICT_a8r8g8b8, PICT_a8, PICT_r5g6b5, 0,
+     fbCompositeSrc_8888x8x0565},
+    {PictOpOver, PICT_a8b8g8r8, PICT_a8, PICT_b5g6r5, 0,
+     fbCompositeSrc_8888x8x0565},
+
+    {PictOpOver, FbFormatSolid, FbFormatNone, PICT_a8r8g8b8, 0,
+     fbCompositeSolid_nx8888},
+    {PictOpOver, FbFormatSolid, FbFormatNone, PICT_x8r8g8b8, 0,
+     fbCompositeSolid_nx8888},
+    {PictOpOver, FbFormatSolid, FbFormatNone, PICT_a8b8g8r8, 0,
+     fbCompositeSolid_nx8888},
+    {PictOpOver, FbFormatSolid, FbFormatNone, PICT_x8b8g8r8, 0,
+     fbCompositeSolid_nx8888},
+    {PictOpOver, FbFormatSolid, FbFormatNone, PICT_r5g6b5, 0,
+     fbCompositeSolid_nx0565},
+    {PictOpOver, FbFormatSolid, FbFormatNone, PICT_b5g6r5, 0,
+     fbCompositeSolid_nx0565},
+
+    {PictOpOver, PICT_a8r8g8b8, FbFormatNone, PICT_a8r8g8b8, 0,
+     fbCompositeSrc_8888x8888},
+    {PictOpOver, PICT_a8r8g8b8, FbFormatNone, PICT_x8r8g8b8, 0,
+     fbCompositeSrc_8888x8888},
+    {PictOpOver, PICT_a8r8g8b8, FbFormatNone, PICT_r8g8b8, 0,
+     fbCompositeSrc_8888x0888},
+    {PictOpOver, PICT_a8r8g8b8, FbFormatNone, PICT_r5g6b5, 0,
+     fbCompositeSrc_8888x0565},
+    {PictOpOver, PICT_a8b8g8r8, FbFormatNone, PICT_a8b8g8r8, 0,
+     fbCompositeSrc_8888x8888},
+    {PictOpOver, PICT_a8b8g8r8, FbFormatNone, PICT_x8b8g8r8, 0,
+     fbCompositeSrc_8888x8888},
+    {PictOpOver, PICT_a8b8g8r8, FbFormatNone, PICT_b8g8r8, 0,
+     fbCompositeSrc_8888x0888},
+    {PictOpOver, PICT_a8b8g8r8, FbFormatNone, PICT_b5g6r5, 0,
+     fbCompositeSrc_8888x0565},
+    {PictOpOver, PICT_r5g6b5, FbFormatNone, PICT_r5g6b5, 0,
+     fbCompositeSrc_0565x0565},
+    {PictOpOver, PICT_b5g6r5, FbFormatNone, PICT_b5g6r5, 0,
+     fbCompositeSrc_0565x0565},
+
+    {PictOpSrc, FbFormatSolid, FbFormatNone, PICT_a8r8g8b8, 0,
+     fbCompositeSolidFill},
+    {PictOpSrc, FbFormatSolid, FbFormatNone, PICT_x8r8g8b8, 0,
+     fbCompositeSolidFill},
+    {PictOpSrc, FbFormatSolid, FbFormatNone, PICT_a8b8g8r8, 0,
+     fbCompositeSolidFill},
+    {PictOpSrc, FbFormatSolid, FbFormatNone, PICT_x8b8g8r8, 0,
+     fbCompositeSolidFill},
+    {PictOpSrc, FbFormatSolid, FbFormatNone, PICT_r8g8b8, 0,
+     fbCompositeSolidFill},
+    {PictOpSrc, FbFormatSolid, FbFormatNone, PICT_b8g8r8, 0,
+     fbCompositeSolidFill},
+    {PictOpSrc, FbFormatSolid, FbFormatNone, PICT_r5g6b5, 0,
+     fbCompositeSolidFill},
+    {PictOpSrc, FbFormatSolid, FbFormatNone, PICT_b5g6r5, 0,
+     fbCompositeSolidFill},
+    {PictOpSrc, FbFormatSolid, FbFormatNone, PICT_a8, 0,
+     fbCompositeSolidFill},
+
+    {PictOpSrc, PICT_r5g6b5, FbFormatNone, PICT_a8r8g8b8, 0,
+     fbCompositeSrcSrc_0565x8888},
+    {PictOpSrc, PICT_r5g6b5, FbFormatNone, PICT_x8r8g8b8, 0,
+     fbCompositeSrcSrc_0565x8888},
+    {PictOpSrc, PICT_b5g6r5, FbFormatNone, PICT_a8b8g8r8, 0,
+     fbCompositeSrcSrc_0565x8888},
+    {PictOpSrc, PICT_b5g6r5, FbFormatNone, PICT_x8b8g8r8, 0,
+     fbCompositeSrcSrc_0565x8888},
+
+    {PictOpAdd, PICT_a8r8g8b8, FbFormatNone, PICT_a8r8g8b8, FbPathSrcRepeat,
+     fbCompositeSrcAdd_8888x8888},
+    {PictOpAdd, PICT_a8b8g8r8, FbFormatNone, PICT_a8b8g8r8, FbPathSrcRepeat,
+     fbCompositeSrcAdd_8888x8888},
+    {PictOpAdd, PICT_a8, FbFormatNone, PICT_a8, FbPathSrcRepeat,
+     fbCompositeSrcAdd_8000x8000},
+    {PictOpAdd, PICT_a1, FbFormatNone, PICT_a1, FbPathSrcRepeat,
+     fbCompositeSrcAdd_1000x1000},
+    {PictOpAdd, FbFormatSolid, PICT_a8, PICT_a8, 0,
+     fbCompositeSolidMaskAdd_nx8x8000},
+};
+
+#define FB_FAST_PATH_CACHE	32
+
+typedef struct _FbFastPathCache {
+    CARD8 op;
+    CARD8 flags;
+    CARD32 src;
+    CARD32 mask;
+    CARD32 dst;
+    FbFastPathPtr path;
+} FbFastPathCacheRec;
+
+/* flags describing the pictures, only used in the cache key */
+#define FbPictValid		(1 << 0)
+#define FbPictComponentAlpha	(1 << 1)
+#define FbPictSrcRepeat		(1 << 2)
+
+static FbFastPathCacheRec fbFastPathCache[FB_FAST_PATH_CACHE];
+
+static FbFastPathPtr
+fbLookupFastPath(CARD8 op, CARD32 src, CARD32 mask, CARD32 dst, CARD8 flags)
+{
+    FbFastPathCacheRec *c;
+
+    FbFastPathPtr path;
+
+    unsigned hash;
+
+    unsigned i;
+
+    hash = op * 0x9e3779b1U ^ src ^ (mask << 7) ^ (dst << 13) ^ flags;
+    hash ^= hash >> 16;
+    c = &fbFastPathCache[(hash ^ (hash >> 8)) % FB_FAST_PATH_CACHE];
+    if (c->flags == flags && c->op == op &&
+        c->src == src && c->mask == mask && c->dst == dst)
+        return c->path;
+
+    path = NULL;
+    for (i = 0; i < sizeof(fbFastPaths) / sizeof(fbFastPaths[0]); i++) {
+        const FbFastPathRec *p = &fbFastPaths[i];
+
+        if (p->op != op || p->src != src || p->mask != mask || p->dst != dst)
+            continue;
+        if (((p->flags & FbPathComponentAlpha) != 0) !=
+            ((flags & FbPictComponentAlpha) != 0))
+            continue;
+        if ((flags & FbPictSrcRepeat) && !(p->flags & FbPathSrcRepeat))
+            continue;
+        path = (FbFastPathPtr) p;
+        break;
+    }
+
+    c->op = op;
+    c->flags = flags;
+    c->src = src;
+    c->mask = mask;
+    c->dst = dst;
+    c->path = path;
+    return path;
+}
+
 # define mod(a,b)	((b) == 1 ? 0 : (a) >= 0 ? (a) % (b) : (b) - (-a) % (b))
 
 void
@@ -852,291 +1352,31 @@ fbComposite(CARD8 op,
         && !pSrc->transform && !(pMask && pMask->transform)
         && !maskAlphaMap && !srcAlphaMap && !dstAlphaMap
         && (pSrc->filter != PictFilterConvolution)
-        && (!pMask || pMask->filter != PictFilterConvolution))
-        switch (op) {
-        case PictOpSrc:
-            break;
-        case PictOpOver:
-            if (pMask) {
-                if (fbCanGetSolid(pSrc) && !maskRepeat) {
-                    srcRepeat = FALSE;
-                    if (PICT_FORMAT_COLOR(pSrc->format)) {
-                        switch (pMask->format) {
-                        case PICT_a8:
-                            switch (pDst->format) {
-                            case PICT_r5g6b5:
-                            case PICT_b5g6r5:
-                                    func = fbCompositeSolidMask_nx8x0565;
-                                break;
-                            case PICT_r8g8b8:
-                            case PICT_b8g8r8:
-                                func = fbCompositeSolidMask_nx8x0888;
-                                break;
-                            case PICT_a8r8g8b8:
-                            case PICT_x8r8g8b8:
-                            case PICT_a8b8g8r8:
-                            case PICT_x8b8g8r8:
-                                    func = fbCompositeSolidMask_nx8x8888;
-                                break;
-                            default:
-                                break;
-                            }
-                            break;
-                        case PICT_a8r8g8b8:
-                            if (pMask->componentAlpha) {
-                                switch (pDst->format) {
-                                case PICT_a8r8g8b8:
-                                case PICT_x8r8g8b8:
-                                        func =
-                                            fbCompositeSolidMask_nx8888x8888C;
-                                    break;
-                                case PICT_r5g6b5:
-                                        func =
-                                            fbCompositeSolidMask_nx8888x0565C;
-                                    break;
-                                default:
-                                    break;
-                                }
-                            }
-                            break;
-                        case PICT_a8b8g8r8:
-                            if (pMask->componentAlpha) {
-                                switch (pDst->format) {
-                                case PICT_a8b8g8r8:
-                                case PICT_x8b8g8r8:
-                                        func =
-                                            fbCompositeSolidMask_nx8888x8888C;
-                                    break;
-                                case PICT_b5g6r5:
-                                        func =
-                                            fbCompositeSolidMask_nx8888x0565C;
-                                    break;
-                                default:
-                                    break;
-                                }
-                            }
-                            break;
-                        case PICT_a1:
-                            switch (pDst->format) {
-                            case PICT_r5g6b5:
-                            case PICT_b5g6r5:
-                            case PICT_r8g8b8:
-                            case PICT_b8g8r8:
-                            case PICT_a8r8g8b8:
-                            case PICT_x8r8g8b8:
-                            case PICT_a8b8g8r8:
-                            case PICT_x8b8g8r8:
-                                func = fbCompositeSolidMask_nx1xn;
-                                break;
-                            default:
-                                break;
-                            }
-                            break;
-                        default:
-                            break;
-                        }
-        default:
-                        break;
-                    }
-                }
-                else if (!srcRepeat) {  /* has mask and non-repeating source */
-                    if (pSrc->pDrawable == pMask->pDrawable &&
-                        xSrc == xMask && ySrc == yMask &&
-                        !pMask->componentAlpha && !maskRepeat) {
-                        /* source == mask: non-premultiplied data */
-                        switch (pSrc->format) {
-                        case PICT_x8b8g8r8:
-                            switch (pMask->format) {
-                            case PICT_a8r8g8b8:
-                            case PICT_a8b8g8r8:
-                                switch (pDst->format) {
-                                case PICT_a8r8g8b8:
-                                case PICT_x8r8g8b8:
-                                    break;
-                                case PICT_r5g6b5:
-                                    break;
-                                default:
-                                    break;
-                                }
-                                break;
-                            default:
-                                break;
-                            }
-                            break;
-                        case PICT_x8r8g8b8:
-                            switch (pMask->format) {
-                            case PICT_a8r8g8b8:
-                            case PICT_a8b8g8r8:
-                                switch (pDst->format) {
-                                case PICT_a8b8g8r8:
-                                case PICT_x8b8g8r8:
-                                    break;
-                                case PICT_r5g6b5:
-                                    break;
-                                default:
-                                    break;
-                                }
-                                break;
-                            default:
-                                break;
-                            }
-                            break;
-                        default:
-                            break;
-                        }
-                        break;
-                    }
-                    else {
-                        /* non-repeating source, repeating mask => translucent window */
-                        if (fbCanGetSolid(pMask)) {
-                            if (pSrc->format == PICT_x8r8g8b8 &&
-                                pDst->format == PICT_x8r8g8b8 &&
-                                pMask->format == PICT_a8) {
-                            }
-                        }
-                    }
-                }
-            }
-            else {              /* no mask */
-
-                if (fbCanGetSolid(pSrc)) {
-                    /* no mask and repeating source */
-                    switch (pSrc->format) {
-                    case PICT_a8r8g8b8:
-                        switch (pDst->format) {
-                        case PICT_a8r8g8b8:
-                        case PICT_x8r8g8b8:
-                            break;
-                        case PICT_r5g6b5:
-                            break;
-                        default:
-                            break;
-                        }
-                        break;
-                    default:
-                        break;
-                    }
-                }
-                else if (!srcRepeat) {
-                    switch (pSrc->format) {
-                    case PICT_a8r8g8b8:
-                        switch (pDst->format) {
-                        case PICT_a8r8g8b8:
-                        case PICT_x8r8g8b8:
-                                func = fbCompositeSrc_8888x8888;
-                            break;
-                        case PICT_r8g8b8:
-                            func = fbCompositeSrc_8888x0888;
-                            break;
-                        case PICT_r5g6b5:
-                            func = fbCompositeSrc_8888x0565;
-                            break;
-                        default:
-                            break;
-                        }
-                        break;
-                    case PICT_x8r8g8b8:
-                        switch (pDst->format) {
-                        case PICT_a8r8g8b8:
-                        case PICT_x8r8g8b8:
-                            break;
-                        default:
-                            break;
-                        }
-                    case PICT_x8b8g8r8:
-                        switch (pDst->format) {
-                        case PICT_a8b8g8r8:
-                        case PICT_x8b8g8r8:
-                            break;
-                        default:
-                            break;
-                        }
-                        break;
-                    case PICT_a8b8g8r8:
-                        switch (pDst->format) {
-                        case PICT_a8b8g8r8:
-                        case PICT_x8b8g8r8:
-                                func = fbCompositeSrc_8888x8888;
-                            break;
-                        case PICT_b8g8r8:
-                            func = fbCompositeSrc_8888x0888;
-                            break;
-                        case PICT_b5g6r5:
-                            func = fbCompositeSrc_8888x0565;
-                            break;
-                        default:
-                            break;
-                        }
-                        break;
-                    case PICT_r5g6b5:
-                        switch (pDst->format) {
-                        case PICT_r5g6b5:
-                            func = fbCompositeSrc_0565x0565;
-                            break;
-                        default:
-                            break;
-                        }
-                        break;
-                    case PICT_b5g6r5:
-                        switch (pDst->format) {
-                        case PICT_b5g6r5:
-                            func = fbCompositeSrc_0565x0565;
-                            break;
-                        default:
-                            break;
-                        }
-                        break;
-                    default:
-                        break;
-                    }
-                }
-            }
-            break;
-        case PictOpAdd:
-            if (pMask == 0) {
-                switch (pSrc->format) {
-                case PICT_a8r8g8b8:
-                    switch (pDst->format) {
-                    case PICT_a8r8g8b8:
-                            func = fbCompositeSrcAdd_8888x8888;
-                        break;
-                    default:
-                        break;
-                    }
-                    break;
-                case PICT_a8b8g8r8:
-                    switch (pDst->format) {
-                    case PICT_a8b8g8r8:
-                            func = fbCompositeSrcAdd_8888x8888;
-                        break;
-                    default:
-                        break;
-                    }
-                    break;
-                case PICT_a8:
-                    switch (pDst->format) {
-                    case PICT_a8:
-                            func = fbCompositeSrcAdd_8000x8000;
-                        break;
-                    default:
-                        break;
-                    }
-                    break;
-                case PICT_a1:
-                    switch (pDst->format) {
-                    case PICT_a1:
-                        func = fbCompositeSrcAdd_1000x1000;
-                        break;
-                    default:
-                        break;
-                    }
-                    break;
-                default:
-                    break;
-                }
-            }
-            break;
+        && (!pMask || pMask->filter != PictFilterConvolution)
+        && (!srcRepeat || pSrc->repeat == RepeatNormal)
+        && !(pMask && pMask->repeat)) {
+        CARD32 maskFormat = pMask ? pMask->format : FbFormatNone;
+
+        CARD8 flags = FbPictValid;
+
+        FbFastPathPtr path = NULL;
+
+        if (pMask && pMask->componentAlpha && PICT_FORMAT_RGB(pMask->format))
+            flags |= FbPictComponentAlpha;
+        if (fbCanGetSolid(pSrc))
+            path = fbLookupFastPath(op, FbFormatSolid, maskFormat,
+                                    pDst->format, flags);
+        if (path)
+            srcRepeat = FALSE;
+        else {
+            if (srcRepeat)
+                flags |= FbPictSrcRepeat;
+            path = fbLookupFastPath(op, pSrc->format, maskFormat,
+                                    pDst->format, flags);
         }
+        if (path)
+            func = path->func;
+    }
 
     if (!func) {
         /* no fast path, use the general code */
@@ -1216,6 +1456,418 @@ fbComposite(CARD8 op,
     REGION_UNINIT(&region);
 }
 
+/*
+ * Glyph runs.
+ *
+ * miGlyphs wraps every glyph in a scratch picture and composites it on
+ * its own, paying for region computation and fast path lookup each
+ * time.  The common cases are handled here in one walk over the list:
+ * with a mask format the glyph bits are added straight into the mask,
+ * which is then composited once; without one, solid OVER text is blended
+ * into the destination through its clip.  Everything else still goes
+ * through miGlyphs.
+ */
+
+#define FbGlyphNone	0
+#define FbGlyphA1	1
+#define FbGlyphA8	2
+#define FbGlyphARGB	3
+
+static int
+fbGlyphKind(PictFormatPtr pFormat)
+{
+    switch (pFormat->format) {
+    case PICT_a1:
+        return FbGlyphA1;
+    case PICT_a8:
+        return FbGlyphA8;
+    case PICT_a8r8g8b8:
+        return FbGlyphARGB;
+    }
+    return FbGlyphNone;
+}
+
+static Bool
+fbGlyphKindsOK(int nlist, GlyphListPtr list)
+{
+    while (nlist--) {
+        if (fbGlyphKind(list->format) == FbGlyphNone)
+            return FALSE;
+        list++;
+    }
+    return TRUE;
+}
+
+#if BITMAP_BIT_ORDER == MSBFirst
+#define FbGlyphBit(line,x)	(((line)[(x) >> 5] >> (31 - ((x) & 31))) & 1)
+#else
+#define FbGlyphBit(line,x)	(((line)[(x) >> 5] >> ((x) & 31)) & 1)
+#endif
+
+/*
+ * Add the width x height block of glyph pixels at (sx, sy) into the
+ * mask at dst, which is an a8 or a8r8g8b8 line pointer.
+ */
+static void
+fbGlyphAdd(int kind, GlyphPtr glyph, int depth, int sx, int sy,
+           CARD8 *dst, FbStride dstStride, Bool maskARGB, int width,
+           int height)
+{
+    int srcStride = GlyphStride(glyph, depth);
+
+    CARD8 *srcLine = GlyphBits(glyph) + sy * srcStride;
+
+    CARD16 t;
+
+    int x;
+
+    for (; height--; srcLine += srcStride, dst += dstStride) {
+        CARD32 *src32 = (CARD32 *) srcLine;
+
+        CARD8 *d8 = dst;
+
+        CARD32 *d32 = (CARD32 *) dst;
+
+        switch (kind) {
+        case FbGlyphA1:
+            for (x = 0; x < width; x++) {
+                if (!FbGlyphBit(src32, sx + x))
+                    continue;
+                if (maskARGB)
+                    d32[x] |= 0xff000000;
+                else
+                    d8[x] = 0xff;
+            }
+            break;
+        case FbGlyphA8:
+            for (x = 0; x < width; x++) {
+                CARD8 s = srcLine[sx + x];
+
+                if (!s)
+                    continue;
+                if (maskARGB)
+                    d32[x] = (d32[x] & 0xffffff) |
+                        FbAdd((CARD32) s << 24, d32[x], 24, t);
+                else
+                    d8[x] = FbAdd(s, d8[x], 0, t);
+            }
+            break;
+        case FbGlyphARGB:
+            for (x = 0; x < width; x++) {
+                CARD32 s = src32[sx + x];
+
+                if (!s)
+                    continue;
+                if (maskARGB)
+                    d32[x] = FbAdd(s, d32[x], 0, t) | FbAdd(s, d32[x], 8, t) |
+                        FbAdd(s, d32[x], 16, t) | FbAdd(s, d32[x], 24, t);
+                else
+                    d8[x] = FbAdd(s >> 24, d8[x], 0, t);
+            }
+            break;
+        }
+    }
+}
+
+static Bool
+fbGlyphsMask(CARD8 op,
+             PicturePtr pSrc,
+             PicturePtr pDst,
+             PictFormatPtr maskFormat,
+             INT16 xSrc,
+             INT16 ySrc, int nlist, GlyphListPtr list, GlyphPtr * glyphs)
+{
+    ScreenPtr pScreen = pDst->pDrawable->pScreen;
+
+    PixmapPtr pMaskPixmap;
+
+    PicturePtr pMask;
+
+    FbBits *maskBits;
+
+    FbStride maskStride;
+
+    int maskBpp, maskXoff _X_UNUSED, maskYoff _X_UNUSED;
+
+    int xDst = list->xOff, yDst = list->yOff;
+
+    int width, height, x, y, n, error;
+
+    Bool maskARGB;
+
+    CARD32 component_alpha;
+
+    BoxRec extents;
+
+    GlyphPtr glyph;
+
+    if (maskFormat->format != PICT_a8 && maskFormat->format != PICT_a8r8g8b8)
+        return FALSE;
+
+    miGlyphExtents(nlist, list, glyphs, &extents);
+    if (extents.x2 <= extents.x1 || extents.y2 <= extents.y1)
+        return TRUE;
+    width = extents.x2 - extents.x1;
+    height = extents.y2 - extents.y1;
+
+    pMaskPixmap = miGlyphMaskAcquire(pScreen, maskFormat->depth,
+                                     width, height);
+    if (!pMaskPixmap)
+        return TRUE;
+    component_alpha = maskFormat->format == PICT_a8r8g8b8;
+    pMask = CreatePicture(0, &pMaskPixmap->drawable, maskFormat,
+                          CPComponentAlpha, &component_alpha, serverClient,
+                          &error);
+    if (!pMask) {
+        miGlyphMaskRelease(pScreen, pMaskPixmap);
+        return TRUE;
+    }
+    fbGetDrawable(&pMaskPixmap->drawable, maskBits, maskStride, maskBpp,
+                  maskXoff, maskYoff);
+    maskARGB = maskBpp == 32;
+    maskStride *= sizeof(FbBits);
+    /* the pixmap may be larger than the run, only clear what is used */
+    for (y = 0; y < height; y++)
+        memset((CARD8 *) maskBits + y * maskStride, 0, width * (maskBpp >> 3));
+
+    x = -extents.x1;
+    y = -extents.y1;
+    while (nlist--) {
+        int kind = fbGlyphKind(list->format);
+
+        int depth = list->format->depth;
+
+        x += list->xOff;
+        y += list->yOff;
+        n = list->len;
+        while (n--) {
+            int x1, y1, x2, y2;
+
+            glyph = *glyphs++;
+            x1 = max(x - glyph->info.x, 0);
+            y1 = max(y - glyph->info.y, 0);
+            x2 = min(x - glyph->info.x + glyph->info.width, width);
+            y2 = min(y - glyph->info.y + glyph->info.height, height);
+            if (x1 < x2 && y1 < y2)
+                fbGlyphAdd(kind, glyph, depth,
+                           x1 - (x - glyph->info.x), y1 - (y - glyph->info.y),
+                           (CARD8 *) maskBits + y1 * maskStride +
+                           x1 * (maskBpp >> 3), maskStride, maskARGB,
+                           x2 - x1, y2 - y1);
+            x += glyph->info.xOff;
+            y += glyph->info.yOff;
+        }
+        list++;
+    }
+
+    CompositePicture(op, pSrc, pMask, pDst,
+                     xSrc + extents.x1 - xDst, ySrc + extents.y1 - yDst,
+                     0, 0, extents.x1, extents.y1, width, height);
+    FreePicture((pointer) pMask, (XID) 0);
+    miGlyphMaskRelease(pScreen, pMaskPixmap);
+    return TRUE;
+}
+
+/*
+ * Solid OVER through the glyph at (sx, sy) onto an 8888 destination;
+ * the loops are the ones of the nx8x8888 and nx8888x8888C fast paths.
+ */
+static void
+fbGlyphOver(int kind, GlyphPtr glyph, int depth, int sx, int sy,
+            CARD32 src, CARD32 *dstLine, FbStride dstStride, CARD32 dstMask,
+            int width, int height)
+{
+    int srcStride = GlyphStride(glyph, depth);
+
+    CARD8 *srcLine = GlyphBits(glyph) + sy * srcStride;
+
+    CARD32 srca = src >> 24;
+
+    CARD32 *dst, d, m, n, o, p;
+
+    int x;
+
+    for (; height--; srcLine += srcStride, dstLine += dstStride) {
+        CARD32 *src32 = (CARD32 *) srcLine;
+
+        dst = dstLine;
+        switch (kind) {
+        case FbGlyphA1:
+            for (x = 0; x < width; x++) {
+                if (FbGlyphBit(src32, sx + x)) {
+                    if (srca == 0xff)
+                        dst[x] = src & dstMask;
+                    else
+                        dst[x] = fbOver(src, dst[x]) & dstMask;
+                }
+            }
+            break;
+        case FbGlyphA8:
+            for (x = 0; x < width; x++) {
+                CARD8 a = srcLine[sx + x];
+
+                if (a == 0xff) {
+                    if (srca == 0xff)
+                        dst[x] = src & dstMask;
+                    else
+                        dst[x] = fbOver(src, dst[x]) & dstMask;
+                }
+                else if (a) {
+                    d = fbIn(src, a);
+                    dst[x] = fbOver(d, dst[x]) & dstMask;
+                }
+            }
+            break;
+        case FbGlyphARGB:
+            for (x = 0; x < width; x++) {
+                CARD32 ma = src32[sx + x];
+
+                if (ma == 0xffffffff) {
+                    if (srca == 0xff)
+                        dst[x] = src & dstMask;
+                    else
+                        dst[x] = fbOver(src, dst[x]) & dstMask;
+                }
+                else if (ma) {
+                    d = dst[x];
+                    FbInOverC(src, srca, ma, d, 0, m);
+                    FbInOverC(src, srca, ma, d, 8, n);
+                    FbInOverC(src, srca, ma, d, 16, o);
+                    FbInOverC(src, srca, ma, d, 24, p);
+                    dst[x] = m | n | o | p;
+                }
+            }
+            break;
+        }
+    }
+}
+
+/* fbComposeGetSolid bails out with a bare return */
+static void
+fbGlyphGetSolid(PicturePtr pSrc, CARD32 format, CARD32 *color)
+{
+    CARD32 src;
+
+    *color = 0;
+    fbComposeGetSolid(pSrc, src, format);
+    *color = src;
+}
+
+static Bool
+fbGlyphsDirect(CARD8 op,
+               PicturePtr pSrc,
+               PicturePtr pDst,
+               INT16 xSrc,
+               INT16 ySrc, int nlist, GlyphListPtr list, GlyphPtr * glyphs)
+{
+    RegionPtr pClip = pDst->pCompositeClip;
+
+    BoxPtr pExtents = REGION_EXTENTS(pClip);
+
+    BoxPtr pClipBoxes = REGION_RECTS(pClip);
+
+    int nClipBoxes = REGION_NUM_RECTS(pClip);
+
+    FbBits *dstBits;
+
+    FbStride dstStride;
+
+    int dstBpp, dstXoff, dstYoff;
+
+    CARD32 src, dstMask;
+
+    int x, y, n;
+
+    GlyphPtr glyph;
+
+    if (op != PictOpOver || !fbCanGetSolid(pSrc) ||
+        pSrc->pDrawable->type != DRAWABLE_PIXMAP ||
+        pSrc->clientClipType != CT_NONE || pSrc->alphaMap ||
+        pDst->alphaMap ||
+        (pDst->format != PICT_a8r8g8b8 && pDst->format != PICT_x8r8g8b8))
+        return FALSE;
+
+    fbGlyphGetSolid(pSrc, pDst->format, &src);
+    if (src == 0)
+        return TRUE;
+    dstMask = FbFullMask(pDst->pDrawable->depth);
+
+    fbGetDrawable(pDst->pDrawable, dstBits, dstStride, dstBpp, dstXoff,
+                  dstYoff);
+
+    x = pDst->pDrawable->x;
+    y = pDst->pDrawable->y;
+    while (nlist--) {
+        int kind = fbGlyphKind(list->format);
+
+        int depth = list->format->depth;
+
+        x += list->xOff;
+        y += list->yOff;
+        n = list->len;
+        while (n--) {
+            BoxRec box;
+
+            BoxPtr pBox;
+
+            int i;
+
+            glyph = *glyphs++;
+            box.x1 = x - glyph->info.x;
+            box.y1 = y - glyph->info.y;
+            box.x2 = box.x1 + glyph->info.width;
+            box.y2 = box.y1 + glyph->info.height;
+            x += glyph->info.xOff;
+            y += glyph->info.yOff;
+            if (box.x1 >= pExtents->x2 || box.x2 <= pExtents->x1 ||
+                box.y1 >= pExtents->y2 || box.y2 <= pExtents->y1)
+                continue;
+
+            /* clip boxes are sorted by y1 */
+            for (i = 0, pBox = pClipBoxes; i < nClipBoxes; i++, pBox++) {
+                int x1, y1, x2, y2;
+
+                if (pBox->y1 >= box.y2)
+                    break;
+                if (pBox->y2 <= box.y1)
+                    continue;
+                x1 = max(box.x1, pBox->x1);
+                x2 = min(box.x2, pBox->x2);
+                y1 = max(box.y1, pBox->y1);
+                y2 = min(box.y2, pBox->y2);
+                if (x1 >= x2)
+                    continue;
+                fbGlyphOver(kind, glyph, depth, x1 - box.x1, y1 - box.y1,
+                            src, (CARD32 *) dstBits +
+                            (y1 + dstYoff) * dstStride + x1 + dstXoff,
+                            dstStride, dstMask, x2 - x1, y2 - y1);
+            }
+        }
+        list++;
+    }
+    return TRUE;
+}
+
+void
+fbGlyphs(CARD8 op,
+         PicturePtr pSrc,
+         PicturePtr pDst,
+         PictFormatPtr maskFormat,
+         INT16 xSrc,
+         INT16 ySrc, int nlist, GlyphListPtr list, GlyphPtr * glyphs)
+{
+    if (fbGlyphKindsOK(nlist, list)) {
+        if (maskFormat) {
+            if (fbGlyphsMask(op, pSrc, pDst, maskFormat, xSrc, ySrc,
+                             nlist, list, glyphs))
+                return;
+        }
+        else if (fbGlyphsDirect(op, pSrc, pDst, xSrc, ySrc,
+                                nlist, list, glyphs))
+            return;
+    }
+    miGlyphs(op, pSrc, pDst, maskFormat, xSrc, ySrc, nlist, list, glyphs);
+}
 
 Bool
 fbPictureInit(ScreenPtr pScreen, PictFormatPtr formats, int nformats)
@@ -1226,13 +1878,15 @@ fbPictureInit(ScreenPtr pScreen, PictFormatPtr formats, int nformats)
 
     if (!miPictureInit(pScreen, formats, nformats))
         return FALSE;
+    fbComposeInit();
     ps = GetPictureScreen(pScreen);
     ps->Composite = fbComposite;
-    ps->Glyphs = miGlyphs;
+    ps->Glyphs = fbGlyphs;
     ps->CompositeRects = miCompositeRects;
     ps->RasterizeTrapezoid = fbRasterizeTrapezoid;
     ps->AddTraps = fbAddTraps;
     ps->AddTriangles = fbAddTriangles;
+    ps->Trapezoids = fbTrapezoids;
 
 
     return TRUE;
@@ -72,6 +72,10 @@
 #define Green(x) (((x) >> 8) & 0xff)
 #define Blue(x) ((x) & 0xff)
 
+/* colour table entry for a 16.16 gradient offset, before the spread */
+#define FbGradientIndex(pos) \
+    ((int) (((pos) * PICT_GRADIENT_STOPTABLE_SIZE - 1) >> 16))
+
 /**
  * Returns TRUE if the fbComposeGetSolid can be used to get a single solid
  * color representing every source sampling location of the picture.
@@ -370,6 +374,15 @@ typedef struct _FbComposeData {
     CARD16 height;
 } FbComposeData;
 
+typedef FASTCALL void (*fetchProc) (const FbBits * bits, int x, int width,
+                                    CARD32 *buffer, miIndexedPtr indexed);
+typedef FASTCALL void (*storeProc) (FbBits * bits, const CARD32 *values, int x,
+                                    int width, miIndexedPtr indexed);
+
+typedef void (*GradientIndexProc) (const SourcePictPtr pGradient,
+                                   double rx, double ry, double cx, double cy,
+                                   int n, int *ipos);
+
 typedef FASTCALL void (*CombineMaskU) (CARD32 *src, const CARD32 *mask,
                                        int width);
 typedef FASTCALL void (*CombineFuncU) (CARD32 *dest, const CARD32 *src,
@@ -385,6 +398,9 @@ typedef struct _FbComposeFunctions {
 
 /* fbcompose.c */
 
+void
+ fbComposeInit(void);
+
 void
 
 fbCompositeGeneral(CARD8 op,
@@ -406,6 +422,16 @@ fbRasterizeEdges(FbBits * buf,
                  int stride,
                  RenderEdge * l, RenderEdge * r, xFixed t, xFixed b);
 
+/* Destination of fbRasterizeSpan */
+typedef struct _FbSpanBits {
+    FbBits *bits;
+    FbStride stride;
+    int bpp;
+} FbSpanBitsRec, *FbSpanBitsPtr;
+
+void
+ fbRasterizeSpan(pointer closure, int y, int x, int len, CARD8 *coverage);
+
 /* fbpict.c */
 CARD32
  fbOver(CARD32 x, CARD32 y);
@@ -582,6 +608,78 @@ fbCompositeSolidMask_nx1xn(CARD8 op,
 
 void
 
+fbCompositeSrc_8888x8x0565(CARD8 op,
+                           PicturePtr pSrc,
+                           PicturePtr pMask,
+                           PicturePtr pDst,
+                           INT16 xSrc,
+                           INT16 ySrc,
+                           INT16 xMask,
+                           INT16 yMask,
+                           INT16 xDst, INT16 yDst, CARD16 width, CARD16 height);
+
+void
+
+fbCompositeSrcSrc_0565x8888(CARD8 op,
+                            PicturePtr pSrc,
+                            PicturePtr pMask,
+                            PicturePtr pDst,
+                            INT16 xSrc,
+                            INT16 ySrc,
+                            INT16 xMask,
+                            INT16 yMask,
+                            INT16 xDst, INT16 yDst, CARD16 width, CARD16 height);
+
+void
+
+fbCompositeSolidMaskAdd_nx8x8000(CARD8 op,
+                                 PicturePtr pSrc,
+                                 PicturePtr pMask,
+                                 PicturePtr pDst,
+                                 INT16 xSrc,
+                                 INT16 ySrc,
+                                 INT16 xMask,
+                                 INT16 yMask,
+                                 INT16 xDst, INT16 yDst, CARD16 width, CARD16 height);
+
+void
+
+fbCompositeSolidFill(CARD8 op,
+                     PicturePtr pSrc,
+                     PicturePtr pMask,
+                     PicturePtr pDst,
+                     INT16 xSrc,
+                     INT16 ySrc,
+                     INT16 xMask,
+                     INT16 yMask,
+                     INT16 xDst, INT16 yDst, CARD16 width, CARD16 height);
+
+void
+
+fbCompositeSolid_nx8888(CARD8 op,
+                        PicturePtr pSrc,
+                        PicturePtr pMask,
+                        PicturePtr pDst,
+                        INT16 xSrc,
+                        INT16 ySrc,
+                        INT16 xMask,
+                        INT16 yMask,
+                        INT16 xDst, INT16 yDst, CARD16 width, CARD16 height);
+
+void
+
+fbCompositeSolid_nx0565(CARD8 op,
+                        PicturePtr pSrc,
+                        PicturePtr pMask,
+                        PicturePtr pDst,
+                        INT16 xSrc,
+                        INT16 ySrc,
+                        INT16 xMask,
+                        INT16 yMask,
+                        INT16 xDst, INT16 yDst, CARD16 width, CARD16 height);
+
+void
+
 fbComposite(CARD8 op,
             PicturePtr pSrc,
             PicturePtr pMask,
@@ -591,6 +689,34 @@ fbComposite(CARD8 op,
             INT16 xMask,
             INT16 yMask, INT16 xDst, INT16 yDst, CARD16 width, CARD16 height);
 
+void
+
+fbGlyphs(CARD8 op,
+         PicturePtr pSrc,
+         PicturePtr pDst,
+         PictFormatPtr maskFormat,
+         INT16 xSrc,
+         INT16 ySrc, int nlist, GlyphListPtr list, GlyphPtr * glyphs);
+
+/* fbsimd.c */
+
+void
+
+fbSimdCombineInit(CombineFuncU * combineU,
+                  CombineFuncC * combineC, CombineMaskU * combineMaskU);
+
+void
+ fbSimdConvertInit(void);
+
+fetchProc
+fbSimdFetchProc(CARD32 format);
+
+storeProc
+fbSimdStoreProc(CARD32 format);
+
+void
+ fbSimdGradientInit(GradientIndexProc * radial, GradientIndexProc * conical);
+
 /* fbtrap.c */
 
 void
@@ -607,4 +733,12 @@ void
 fbAddTriangles(PicturePtr pPicture,
                INT16 xOff, INT16 yOff, int ntri, xTriangle * tris);
 
+void
+
+fbTrapezoids(CARD8 op,
+             PicturePtr pSrc,
+             PicturePtr pDst,
+             PictFormatPtr maskFormat,
+             INT16 xSrc, INT16 ySrc, int ntrap, xTrapezoid * traps);
+
 #endif                          /* _FBPICT_H_ */
@@ -0,0 +1,1398 @@
+/*
+ *
+ * Copyright © 2026 Ace Husky <acehusky12@gmail.com>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of Ace Husky not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  Ace Husky makes no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * ACE HUSKY DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL ACE HUSKY BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Vector versions of the Porter-Duff combiners in fbcompose.c.
+ *
+ * Every function here produces exactly the bits the C version does; the
+ * rounding of FbByteMul, FbByteMulAdd and FbByteAddMul (including the
+ * slightly different green channel rounding of the latter) is reproduced
+ * lane for lane.  Operators whose C version divides per pixel (Saturate,
+ * Disjoint, Conjoint) or whose mask handling is irregular are left alone
+ * and keep using the C code.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include "fb.h"
+
+#include <string.h>
+#include <math.h>
+
+#include "picturestr.h"
+#include "mipict.h"
+#include "fbpict.h"
+
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define FB_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define FB_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#ifdef FB_SIMD_X86
+
+#define SSE2 __attribute__ ((target("sse2")))
+#define SSSE3 __attribute__ ((target("ssse3")))
+#define AVX2 __attribute__ ((target("avx2")))
+
+/*
+ * SSE2, four pixels at a time
+ */
+
+/* x_c = (x_c * a_c) / 255, rounded as FbByteMul */
+SSE2 static INLINE __m128i
+fbMulSSE2(__m128i x, __m128i a)
+{
+    __m128i zero = _mm_setzero_si128();
+
+    __m128i half = _mm_set1_epi16(0x80);
+
+    __m128i lo, hi;
+
+    lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(x, zero),
+                                       _mm_unpacklo_epi8(a, zero)), half);
+    hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(x, zero),
+                                       _mm_unpackhi_epi8(a, zero)), half);
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+    return _mm_packus_epi16(lo, hi);
+}
+
+/* replicate the alpha byte of each pixel into all four channels */
+SSE2 static INLINE __m128i
+fbAlphaSSE2(__m128i x)
+{
+    x = _mm_srli_epi32(x, 24);
+    x = _mm_or_si128(x, _mm_slli_epi32(x, 8));
+    return _mm_or_si128(x, _mm_slli_epi32(x, 16));
+}
+
+SSE2 static INLINE __m128i
+fbNotSSE2(__m128i x)
+{
+    return _mm_xor_si128(x, _mm_set1_epi32(-1));
+}
+
+/*
+ * One pixel worth of x_c * a + y_c * b in 32 bit lanes divided by 255.
+ * FbByteAddMul rounds green as (257 * v + 0x8000) >> 16 and the other
+ * channels as FbByteMul does; the two differ for a few sums.
+ */
+SSE2 static INLINE __m128i
+fbDiv255SSE2(__m128i v)
+{
+    __m128i green = _mm_set_epi32(0, 0, -1, 0);
+
+    __m128i t, g;
+
+    t = _mm_add_epi32(v, _mm_set1_epi32(0x80));
+    t = _mm_srli_epi32(_mm_add_epi32(t, _mm_srli_epi32(t, 8)), 8);
+    g = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(v, 8), v),
+                      _mm_set1_epi32(0x8000));
+    g = _mm_srli_epi32(g, 16);
+    return _mm_or_si128(_mm_and_si128(green, g), _mm_andnot_si128(green, t));
+}
+
+/* x_c = min((x_c * a + y_c * b) / 255, 255), as FbByteAddMul */
+SSE2 static INLINE __m128i
+fbAddMulSSE2(__m128i x, __m128i a, __m128i y, __m128i b)
+{
+    __m128i zero = _mm_setzero_si128();
+
+    __m128i xy, ab, p0, p1, p2, p3;
+
+    xy = _mm_unpacklo_epi8(x, zero);
+    ab = _mm_unpacklo_epi8(a, zero);
+    p0 = _mm_unpacklo_epi8(y, zero);
+    p1 = _mm_unpacklo_epi8(b, zero);
+    p2 = _mm_madd_epi16(_mm_unpackhi_epi16(xy, p0), _mm_unpackhi_epi16(ab, p1));
+    p0 = _mm_madd_epi16(_mm_unpacklo_epi16(xy, p0), _mm_unpacklo_epi16(ab, p1));
+    p1 = p2;
+
+    xy = _mm_unpackhi_epi8(x, zero);
+    ab = _mm_unpackhi_epi8(a, zero);
+    p2 = _mm_unpackhi_epi8(y, zero);
+    p3 = _mm_unpackhi_epi8(b, zero);
+    y = _mm_madd_epi16(_mm_unpackhi_epi16(xy, p2), _mm_unpackhi_epi16(ab, p3));
+    p2 = _mm_madd_epi16(_mm_unpacklo_epi16(xy, p2), _mm_unpacklo_epi16(ab, p3));
+    p3 = y;
+
+    p0 = _mm_packs_epi32(fbDiv255SSE2(p0), fbDiv255SSE2(p1));
+    p2 = _mm_packs_epi32(fbDiv255SSE2(p2), fbDiv255SSE2(p3));
+    return _mm_packus_epi16(p0, p2);
+}
+
+/*
+ * The loops run four pixels at a time and push the last few through a
+ * padded copy, so each operator only has to spell out one vector step.
+ */
+#define FbSimdCombineU(name, attr, vec, n, load, store, op)		\
+attr static FASTCALL void						\
+name(CARD32 *dest, const CARD32 *src, int width)			\
+{									\
+    CARD32 d[n], s[n];							\
+									\
+    for (; width >= n; width -= n, dest += n, src += n) {		\
+        vec vs = load((const vec *) src);				\
+        vec vd = load((const vec *) dest);				\
+									\
+        store((vec *) dest, op);					\
+    }									\
+    if (width) {							\
+        vec vs, vd;							\
+									\
+        memset(s, 0, sizeof(s));					\
+        memset(d, 0, sizeof(d));					\
+        memcpy(s, src, width * sizeof(CARD32));				\
+        memcpy(d, dest, width * sizeof(CARD32));			\
+        vs = load((const vec *) s);					\
+        vd = load((const vec *) d);					\
+        store((vec *) d, op);						\
+        memcpy(dest, d, width * sizeof(CARD32));			\
+    }									\
+}
+
+#define FbSimdCombineC(name, attr, vec, n, load, store, op)		\
+attr static FASTCALL void						\
+name(CARD32 *dest, CARD32 *src, CARD32 *mask, int width)		\
+{									\
+    CARD32 d[n], s[n], m[n];						\
+									\
+    for (; width >= n; width -= n, dest += n, src += n, mask += n) {	\
+        vec vs = load((const vec *) src);				\
+        vec vm = load((const vec *) mask);				\
+        vec vd = load((const vec *) dest);				\
+									\
+        store((vec *) dest, op);					\
+    }									\
+    if (width) {							\
+        vec vs, vm, vd;							\
+									\
+        memset(s, 0, sizeof(s));					\
+        memset(m, 0, sizeof(m));					\
+        memset(d, 0, sizeof(d));					\
+        memcpy(s, src, width * sizeof(CARD32));				\
+        memcpy(m, mask, width * sizeof(CARD32));			\
+        memcpy(d, dest, width * sizeof(CARD32));			\
+        vs = load((const vec *) s);					\
+        vm = load((const vec *) m);					\
+        vd = load((const vec *) d);					\
+        store((vec *) d, op);						\
+        memcpy(dest, d, width * sizeof(CARD32));			\
+    }									\
+}
+
+#define FbSSE2U(name, op) \
+    FbSimdCombineU(name, SSE2, __m128i, 4, _mm_loadu_si128, _mm_storeu_si128, op)
+#define FbSSE2C(name, op) \
+    FbSimdCombineC(name, SSE2, __m128i, 4, _mm_loadu_si128, _mm_storeu_si128, op)
+
+SSE2 static FASTCALL void
+fbCombineMaskUSSE2(CARD32 *src, const CARD32 *mask, int width)
+{
+    CARD32 s[4], m[4];
+
+    for (; width >= 4; width -= 4, src += 4, mask += 4) {
+        __m128i vm = _mm_loadu_si128((const __m128i *) mask);
+
+        _mm_storeu_si128((__m128i *) src,
+                         fbMulSSE2(_mm_loadu_si128((__m128i *) src),
+                                   fbAlphaSSE2(vm)));
+    }
+    if (width) {
+        memset(s, 0, sizeof(s));
+        memset(m, 0, sizeof(m));
+        memcpy(s, src, width * sizeof(CARD32));
+        memcpy(m, mask, width * sizeof(CARD32));
+        _mm_storeu_si128((__m128i *) s,
+                         fbMulSSE2(_mm_loadu_si128((__m128i *) s),
+                                   fbAlphaSSE2(_mm_loadu_si128((__m128i *)
+                                                               m))));
+        memcpy(src, s, width * sizeof(CARD32));
+    }
+}
+
+/* opaque and clear runs of source are common enough to test for */
+SSE2 static INLINE __m128i
+fbOverSSE2(__m128i vs, __m128i vd)
+{
+    int a = _mm_movemask_epi8(_mm_cmpeq_epi8(vs, _mm_set1_epi32(-1)));
+
+    if ((a & 0x8888) == 0x8888)
+        return vs;
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(vs, _mm_setzero_si128())) == 0xffff)
+        return vd;
+    return _mm_adds_epu8(fbMulSSE2(vd, fbAlphaSSE2(fbNotSSE2(vs))), vs);
+}
+
+FbSSE2U(fbCombineOverUSSE2, fbOverSSE2(vs, vd))
+FbSSE2U(fbCombineOverReverseUSSE2,
+        _mm_adds_epu8(fbMulSSE2(vs, fbAlphaSSE2(fbNotSSE2(vd))), vd))
+FbSSE2U(fbCombineInUSSE2, fbMulSSE2(vs, fbAlphaSSE2(vd)))
+FbSSE2U(fbCombineInReverseUSSE2, fbMulSSE2(vd, fbAlphaSSE2(vs)))
+FbSSE2U(fbCombineOutUSSE2, fbMulSSE2(vs, fbAlphaSSE2(fbNotSSE2(vd))))
+FbSSE2U(fbCombineOutReverseUSSE2,
+        fbMulSSE2(vd, fbAlphaSSE2(fbNotSSE2(vs))))
+FbSSE2U(fbCombineAtopUSSE2,
+        fbAddMulSSE2(vs, fbAlphaSSE2(vd), vd, fbAlphaSSE2(fbNotSSE2(vs))))
+FbSSE2U(fbCombineAtopReverseUSSE2,
+        fbAddMulSSE2(vs, fbAlphaSSE2(fbNotSSE2(vd)), vd, fbAlphaSSE2(vs)))
+FbSSE2U(fbCombineXorUSSE2,
+        fbAddMulSSE2(vs, fbAlphaSSE2(fbNotSSE2(vd)), vd,
+                     fbAlphaSSE2(fbNotSSE2(vs))))
+FbSSE2U(fbCombineAddUSSE2, _mm_adds_epu8(vd, vs))
+
+/*
+ * The C versions special case empty and full masks, but multiplying by
+ * 0 or 0xffffffff gives the same bits, so fbCombineMaskValueC is just
+ * fbMulSSE2(vs, vm) and fbCombineMaskC additionally turns the mask into
+ * fbMulSSE2(vm, alpha(vs)).
+ */
+SSE2 static INLINE __m128i
+fbOverReverseCSSE2(__m128i vs, __m128i vd)
+{
+    __m128i clear = _mm_cmpeq_epi32(_mm_srli_epi32(vd, 24),
+                                    _mm_setzero_si128());
+
+    __m128i r = _mm_adds_epu8(fbMulSSE2(vs, fbAlphaSSE2(fbNotSSE2(vd))), vd);
+
+    /* fbCombineOverReverseC stores src untouched over clear pixels */
+    return _mm_or_si128(_mm_and_si128(clear, vs), _mm_andnot_si128(clear, r));
+}
+
+SSE2 static FASTCALL void
+fbCombineSrcCSSE2(CARD32 *dest, CARD32 *src, CARD32 *mask, int width)
+{
+    CARD32 s[4], m[4];
+
+    for (; width >= 4; width -= 4, dest += 4, src += 4, mask += 4)
+        _mm_storeu_si128((__m128i *) dest,
+                         fbMulSSE2(_mm_loadu_si128((__m128i *) src),
+                                   _mm_loadu_si128((__m128i *) mask)));
+    if (width) {
+        memset(s, 0, sizeof(s));
+        memset(m, 0, sizeof(m));
+        memcpy(s, src, width * sizeof(CARD32));
+        memcpy(m, mask, width * sizeof(CARD32));
+        _mm_storeu_si128((__m128i *) s,
+                         fbMulSSE2(_mm_loadu_si128((__m128i *) s),
+                                   _mm_loadu_si128((__m128i *) m)));
+        memcpy(dest, s, width * sizeof(CARD32));
+    }
+}
+
+/* pixels whose mask ends up empty are left alone, whatever the source */
+SSE2 static INLINE __m128i
+fbOverCSSE2(__m128i vs, __m128i vm, __m128i vd)
+{
+    __m128i keep;
+
+    __m128i alpha = fbAlphaSSE2(vs);
+
+    vs = fbMulSSE2(vs, vm);
+    vm = fbMulSSE2(vm, alpha);
+    keep = _mm_cmpeq_epi32(vm, _mm_setzero_si128());
+    vs = _mm_adds_epu8(fbMulSSE2(vd, fbNotSSE2(vm)), vs);
+    return _mm_or_si128(_mm_and_si128(keep, vd), _mm_andnot_si128(keep, vs));
+}
+
+FbSSE2C(fbCombineOverCSSE2, fbOverCSSE2(vs, vm, vd))
+FbSSE2C(fbCombineOverReverseCSSE2, fbOverReverseCSSE2(fbMulSSE2(vs, vm), vd))
+FbSSE2C(fbCombineInCSSE2, fbMulSSE2(fbMulSSE2(vs, vm), fbAlphaSSE2(vd)))
+FbSSE2C(fbCombineOutCSSE2,
+        fbMulSSE2(fbMulSSE2(vs, vm), fbAlphaSSE2(fbNotSSE2(vd))))
+FbSSE2C(fbCombineAddCSSE2, _mm_adds_epu8(vd, fbMulSSE2(vs, vm)))
+
+/*
+ * AVX2, eight pixels at a time.  Only the operators that show up in
+ * nearly every trace (glyphs, antialiased geometry) get the wider paths.
+ */
+
+AVX2 static INLINE __m256i
+fbMulAVX2(__m256i x, __m256i a)
+{
+    __m256i zero = _mm256_setzero_si256();
+
+    __m256i half = _mm256_set1_epi16(0x80);
+
+    __m256i lo, hi;
+
+    lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(x, zero),
+                                             _mm256_unpacklo_epi8(a, zero)),
+                          half);
+    hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(x, zero),
+                                             _mm256_unpackhi_epi8(a, zero)),
+                          half);
+    lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+    hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+    return _mm256_packus_epi16(lo, hi);
+}
+
+AVX2 static INLINE __m256i
+fbAlphaAVX2(__m256i x)
+{
+    x = _mm256_srli_epi32(x, 24);
+    x = _mm256_or_si256(x, _mm256_slli_epi32(x, 8));
+    return _mm256_or_si256(x, _mm256_slli_epi32(x, 16));
+}
+
+AVX2 static INLINE __m256i
+fbNotAVX2(__m256i x)
+{
+    return _mm256_xor_si256(x, _mm256_set1_epi32(-1));
+}
+
+AVX2 static INLINE __m256i
+fbOverAVX2(__m256i vs, __m256i vd)
+{
+    unsigned a = _mm256_movemask_epi8(_mm256_cmpeq_epi8(vs,
+                                                         _mm256_set1_epi32
+                                                         (-1)));
+
+    if ((a & 0x88888888) == 0x88888888)
+        return vs;
+    if (_mm256_testz_si256(vs, vs))
+        return vd;
+    return _mm256_adds_epu8(fbMulAVX2(vd, fbAlphaAVX2(fbNotAVX2(vs))), vs);
+}
+
+#define FbAVX2U(name, op) \
+    FbSimdCombineU(name, AVX2, __m256i, 8, _mm256_loadu_si256, _mm256_storeu_si256, op)
+#define FbAVX2C(name, op) \
+    FbSimdCombineC(name, AVX2, __m256i, 8, _mm256_loadu_si256, _mm256_storeu_si256, op)
+
+AVX2 static FASTCALL void
+fbCombineMaskUAVX2(CARD32 *src, const CARD32 *mask, int width)
+{
+    for (; width >= 8; width -= 8, src += 8, mask += 8) {
+        __m256i vm = _mm256_loadu_si256((const __m256i *) mask);
+
+        _mm256_storeu_si256((__m256i *) src,
+                            fbMulAVX2(_mm256_loadu_si256((__m256i *) src),
+                                      fbAlphaAVX2(vm)));
+    }
+    fbCombineMaskUSSE2(src, mask, width);
+}
+
+AVX2 static INLINE __m256i
+fbOverCAVX2(__m256i vs, __m256i vm, __m256i vd)
+{
+    __m256i keep;
+
+    __m256i alpha = fbAlphaAVX2(vs);
+
+    vs = fbMulAVX2(vs, vm);
+    vm = fbMulAVX2(vm, alpha);
+    keep = _mm256_cmpeq_epi32(vm, _mm256_setzero_si256());
+    vs = _mm256_adds_epu8(fbMulAVX2(vd, fbNotAVX2(vm)), vs);
+    return _mm256_blendv_epi8(vs, vd, keep);
+}
+
+FbAVX2U(fbCombineOverUAVX2, fbOverAVX2(vs, vd))
+FbAVX2U(fbCombineAddUAVX2, _mm256_adds_epu8(vd, vs))
+FbAVX2C(fbCombineOverCAVX2, fbOverCAVX2(vs, vm, vd))
+FbAVX2C(fbCombineAddCAVX2, _mm256_adds_epu8(vd, fbMulAVX2(vs, vm)))
+
+/*
+ * Scanline converters.  These only move bits around, so there is no
+ * rounding to match; each one is the scalar fbFetch_ or fbStore_ loop
+ * spelled out on a vector of pixels.
+ */
+
+SSE2 static FASTCALL void
+fbFetch_x8r8g8b8SSE2(const FbBits * bits, int x, int width, CARD32 *buffer,
+                     miIndexedPtr indexed)
+{
+    const CARD32 *pixel = (const CARD32 *) bits + x;
+
+    __m128i alpha = _mm_set1_epi32(0xff000000);
+
+    for (; width >= 4; width -= 4, pixel += 4, buffer += 4)
+        _mm_storeu_si128((__m128i *) buffer,
+                         _mm_or_si128(_mm_loadu_si128((const __m128i *) pixel),
+                                      alpha));
+    while (width--)
+        *buffer++ = *pixel++ | 0xff000000;
+}
+
+SSE2 static FASTCALL void
+fbStore_x8r8g8b8SSE2(FbBits * bits, const CARD32 *values, int x, int width,
+                     miIndexedPtr indexed)
+{
+    CARD32 *pixel = (CARD32 *) bits + x;
+
+    __m128i rgb = _mm_set1_epi32(0xffffff);
+
+    for (; width >= 4; width -= 4, pixel += 4, values += 4)
+        _mm_storeu_si128((__m128i *) pixel,
+                         _mm_and_si128(_mm_loadu_si128((const __m128i *)
+                                                       values), rgb));
+    while (width--)
+        *pixel++ = *values++ & 0xffffff;
+}
+
+SSE2 static FASTCALL void
+fbFetch_a8SSE2(const FbBits * bits, int x, int width, CARD32 *buffer,
+               miIndexedPtr indexed)
+{
+    const CARD8 *pixel = (const CARD8 *) bits + x;
+
+    __m128i zero = _mm_setzero_si128();
+
+    for (; width >= 16; width -= 16, pixel += 16, buffer += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *) pixel);
+
+        __m128i lo = _mm_unpacklo_epi8(zero, a);
+
+        __m128i hi = _mm_unpackhi_epi8(zero, a);
+
+        _mm_storeu_si128((__m128i *) buffer + 0, _mm_unpacklo_epi16(zero, lo));
+        _mm_storeu_si128((__m128i *) buffer + 1, _mm_unpackhi_epi16(zero, lo));
+        _mm_storeu_si128((__m128i *) buffer + 2, _mm_unpacklo_epi16(zero, hi));
+        _mm_storeu_si128((__m128i *) buffer + 3, _mm_unpackhi_epi16(zero, hi));
+    }
+    while (width--)
+        *buffer++ = (*pixel++) << 24;
+}
+
+SSE2 static FASTCALL void
+fbStore_a8SSE2(FbBits * bits, const CARD32 *values, int x, int width,
+               miIndexedPtr indexed)
+{
+    CARD8 *pixel = (CARD8 *) bits + x;
+
+    for (; width >= 16; width -= 16, pixel += 16, values += 16) {
+        const __m128i *v = (const __m128i *) values;
+
+        __m128i lo = _mm_packs_epi32(_mm_srli_epi32(_mm_loadu_si128(v + 0), 24),
+                                     _mm_srli_epi32(_mm_loadu_si128(v + 1), 24));
+        __m128i hi = _mm_packs_epi32(_mm_srli_epi32(_mm_loadu_si128(v + 2), 24),
+                                     _mm_srli_epi32(_mm_loadu_si128(v + 3), 24));
+
+        _mm_storeu_si128((__m128i *) pixel, _mm_packus_epi16(lo, hi));
+    }
+    while (width--)
+        *pixel++ = *values++ >> 24;
+}
+
+SSE2 static INLINE __m128i
+fbExpand0565SSE2(__m128i p)
+{
+    __m128i r;
+
+    r = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(p, 3),
+                                   _mm_set1_epi32(0xf8)),
+                     _mm_and_si128(_mm_slli_epi32(p, 5),
+                                   _mm_set1_epi32(0xfc00)));
+    r = _mm_or_si128(r, _mm_and_si128(_mm_slli_epi32(p, 8),
+                                      _mm_set1_epi32(0xf80000)));
+    r = _mm_or_si128(r, _mm_and_si128(_mm_srli_epi32(r, 5),
+                                      _mm_set1_epi32(0x70007)));
+    r = _mm_or_si128(r, _mm_and_si128(_mm_srli_epi32(r, 6),
+                                      _mm_set1_epi32(0x300)));
+    return _mm_or_si128(r, _mm_set1_epi32(0xff000000));
+}
+
+SSE2 static FASTCALL void
+fbFetch_r5g6b5SSE2(const FbBits * bits, int x, int width, CARD32 *buffer,
+                   miIndexedPtr indexed)
+{
+    const CARD16 *pixel = (const CARD16 *) bits + x;
+
+    __m128i zero = _mm_setzero_si128();
+
+    for (; width >= 8; width -= 8, pixel += 8, buffer += 8) {
+        __m128i p = _mm_loadu_si128((const __m128i *) pixel);
+
+        _mm_storeu_si128((__m128i *) buffer + 0,
+                         fbExpand0565SSE2(_mm_unpacklo_epi16(p, zero)));
+        _mm_storeu_si128((__m128i *) buffer + 1,
+                         fbExpand0565SSE2(_mm_unpackhi_epi16(p, zero)));
+    }
+    while (width--) {
+        CARD32 p = *pixel++;
+
+        CARD32 r = (((p) << 3) & 0xf8) |
+            (((p) << 5) & 0xfc00) | (((p) << 8) & 0xf80000);
+        r |= (r >> 5) & 0x70007;
+        r |= (r >> 6) & 0x300;
+        *buffer++ = 0xff000000 | r;
+    }
+}
+
+/* the result is sign extended so the signed pack leaves it intact */
+SSE2 static INLINE __m128i
+fbPack0565SSE2(__m128i s)
+{
+    __m128i p;
+
+    p = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(s, 3),
+                                   _mm_set1_epi32(0x001f)),
+                     _mm_and_si128(_mm_srli_epi32(s, 5),
+                                   _mm_set1_epi32(0x07e0)));
+    p = _mm_or_si128(p, _mm_and_si128(_mm_srli_epi32(s, 8),
+                                      _mm_set1_epi32(0xf800)));
+    return _mm_srai_epi32(_mm_slli_epi32(p, 16), 16);
+}
+
+SSE2 static FASTCALL void
+fbStore_r5g6b5SSE2(FbBits * bits, const CARD32 *values, int x, int width,
+                   miIndexedPtr indexed)
+{
+    CARD16 *pixel = (CARD16 *) bits + x;
+
+    for (; width >= 8; width -= 8, pixel += 8, values += 8) {
+        const __m128i *v = (const __m128i *) values;
+
+        _mm_storeu_si128((__m128i *) pixel,
+                         _mm_packs_epi32(fbPack0565SSE2(_mm_loadu_si128(v)),
+                                         fbPack0565SSE2(_mm_loadu_si128
+                                                        (v + 1))));
+    }
+    while (width--) {
+        CARD32 s = *values++;
+
+        *pixel++ = ((s >> 3) & 0x001f) |
+            ((s >> 5) & 0x07e0) | ((s >> 8) & 0xf800);
+    }
+}
+
+#if IMAGE_BYTE_ORDER == LSBFirst
+/*
+ * 24bpp needs a byte shuffle, which is SSSE3.  The fetch loads 16 bytes
+ * for 12 bytes worth of pixels and so stops while two pixels remain.
+ */
+SSSE3 static FASTCALL void
+fbFetch_r8g8b8SSSE3(const FbBits * bits, int x, int width, CARD32 *buffer,
+                    miIndexedPtr indexed)
+{
+    const CARD8 *pixel = (const CARD8 *) bits + 3 * x;
+
+    __m128i shuf = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1,
+                                 6, 7, 8, -1, 9, 10, 11, -1);
+
+    __m128i alpha = _mm_set1_epi32(0xff000000);
+
+    for (; width >= 6; width -= 4, pixel += 12, buffer += 4) {
+        __m128i p = _mm_loadu_si128((const __m128i *) pixel);
+
+        _mm_storeu_si128((__m128i *) buffer,
+                         _mm_or_si128(_mm_shuffle_epi8(p, shuf), alpha));
+    }
+    for (; width; width--, pixel += 3)
+        *buffer++ = Fetch24(pixel) | 0xff000000;
+}
+
+SSSE3 static FASTCALL void
+fbStore_r8g8b8SSSE3(FbBits * bits, const CARD32 *values, int x, int width,
+                    miIndexedPtr indexed)
+{
+    CARD8 *pixel = (CARD8 *) bits + 3 * x;
+
+    __m128i shuf = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9,
+                                 10, 12, 13, 14, -1, -1, -1, -1);
+
+    for (; width >= 4; width -= 4, pixel += 12, values += 4) {
+        __m128i p = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)
+                                                     values), shuf);
+        CARD32 last = _mm_cvtsi128_si32(_mm_srli_si128(p, 8));
+
+        _mm_storel_epi64((__m128i *) pixel, p);
+        memcpy(pixel + 8, &last, sizeof(last));
+    }
+    for (; width; width--, pixel += 3) {
+        CARD32 v = *values++;
+
+        Store24(pixel, v);
+    }
+}
+#endif
+
+/*
+ * Gradient positions in single precision, four pixels at a time.  The
+ * float error stays within one colour table entry for anything that
+ * fits on a screen; offsets are clamped to 32767 gradient lengths so the
+ * conversion to 16.16 can't overflow.
+ */
+
+/* one colour table entry per 1 << GRADIENT_SHIFT units of 16.16 offset */
+#define GRADIENT_SHIFT 6
+
+/* radial recurrences are restarted in double this often */
+#define RADIAL_RESEED 16
+
+SSE2 static INLINE __m128i
+fbGradientIndexSSE2(__m128 u)
+{
+    __m128 limit = _mm_set1_ps(32767.f);
+
+    __m128i p;
+
+    u = _mm_min_ps(_mm_max_ps(u, _mm_sub_ps(_mm_setzero_ps(), limit)), limit);
+    p = _mm_cvttps_epi32(_mm_mul_ps(u, _mm_set1_ps(65536.f)));
+    /* FbGradientIndex: (p * 1024 - 1) >> 16 == ceil(p / 64) - 1 */
+    p = _mm_srai_epi32(_mm_add_epi32(p, _mm_set1_epi32((1 << GRADIENT_SHIFT)
+                                                       - 1)), GRADIENT_SHIFT);
+    return _mm_sub_epi32(p, _mm_set1_epi32(1));
+}
+
+SSE2 static void
+fbRadialIndicesSSE2(const SourcePictPtr pGradient, double rx, double ry,
+                    double cx, double cy, int n, int *ipos)
+{
+    const PictRadialGradient *radial = &pGradient->radial;
+
+    double db = 2 * (cx * radial->dx + cy * radial->dy);
+
+    __m128 a4 = _mm_set1_ps(4 * radial->a);
+
+    __m128 inv2a = _mm_set1_ps(1. / (2 * radial->a));
+
+    __m128 m = _mm_set1_ps(radial->m);
+
+    __m128 bias = _mm_set1_ps(radial->b);
+
+    __m128 stepB = _mm_set1_ps(4 * db);
+
+    __m128 r2d2 = _mm_set1_ps(32 * (cx * cx + cy * cy));
+
+    __m128 zero = _mm_setzero_ps();
+
+    __m128 b, r2, dr2;
+
+    int i = 0, j, k;
+
+    while (i < n) {
+        float sb[4], sr2[4], sdr2[4];
+
+        /*
+         * b and x^2 + y^2 for the next four pixels, and how far x^2 + y^2
+         * moves by the pixels four on.  The discriminant is formed from
+         * them each time; stepping it too loses digits to b^2 once a is
+         * small.
+         */
+        for (j = 0; j < 4; j++) {
+            double x = rx + (i + j) * cx;
+
+            double y = ry + (i + j) * cy;
+
+            sb[j] = 2 * (x * radial->dx + y * radial->dy);
+            sr2[j] = x * x + y * y;
+            sdr2[j] = 8 * x * cx + 16 * cx * cx + 8 * y * cy + 16 * cy * cy;
+        }
+        b = _mm_loadu_ps(sb);
+        r2 = _mm_loadu_ps(sr2);
+        dr2 = _mm_loadu_ps(sdr2);
+
+        for (k = 0; k < RADIAL_RESEED && i < n; k++, i += 4) {
+            __m128 det = _mm_add_ps(_mm_mul_ps(b, b), _mm_mul_ps(a4, r2));
+
+            __m128 s = _mm_sqrt_ps(_mm_max_ps(det, zero));
+
+            __m128 den = _mm_add_ps(b, s);
+
+            __m128 pos = _mm_cmpge_ps(b, zero);
+
+            __m128 sneg, spos;
+
+            __m128i p;
+
+            /*
+             * (s - b) / 2a cancels badly in single precision for b > 0
+             * once a is small, so there the same root is taken as
+             * 2 (x^2 + y^2) / (b + s); a zero denominator means a zero
+             * radius.
+             */
+            sneg = _mm_mul_ps(_mm_sub_ps(s, b), inv2a);
+            spos = _mm_and_ps(_mm_div_ps(_mm_add_ps(r2, r2), den),
+                              _mm_cmpgt_ps(den, zero));
+            s = _mm_or_ps(_mm_and_ps(pos, spos), _mm_andnot_ps(pos, sneg));
+            p = fbGradientIndexSSE2(_mm_add_ps(_mm_mul_ps(s, m), bias));
+            if (n - i >= 4) {
+                _mm_storeu_si128((__m128i *) (ipos + i), p);
+            }
+            else {
+                int tail[4];
+
+                _mm_storeu_si128((__m128i *) tail, p);
+                memcpy(ipos + i, tail, (n - i) * sizeof(int));
+            }
+            b = _mm_add_ps(b, stepB);
+            r2 = _mm_add_ps(r2, dr2);
+            dr2 = _mm_add_ps(dr2, r2d2);
+        }
+    }
+}
+
+/*
+ * atan2 from an odd polynomial for atan on [0, 1] (error below 2e-6
+ * radians) plus the usual octant fixups.  atan2(0, 0) is 0 like libm.
+ */
+SSE2 static INLINE __m128
+fbAtan2SSE2(__m128 y, __m128 x)
+{
+    __m128 sign = _mm_set1_ps(-0.f);
+
+    __m128 ax = _mm_andnot_ps(sign, x);
+
+    __m128 ay = _mm_andnot_ps(sign, y);
+
+    __m128 hi = _mm_max_ps(ax, ay);
+
+    __m128 lo = _mm_min_ps(ax, ay);
+
+    __m128 t, t2, r, mask;
+
+    t = _mm_and_ps(_mm_div_ps(lo, hi),
+                   _mm_cmpgt_ps(hi, _mm_setzero_ps()));
+    t2 = _mm_mul_ps(t, t);
+    r = _mm_set1_ps(-0.01172120f);
+    r = _mm_add_ps(_mm_mul_ps(r, t2), _mm_set1_ps(0.05265332f));
+    r = _mm_add_ps(_mm_mul_ps(r, t2), _mm_set1_ps(-0.11643287f));
+    r = _mm_add_ps(_mm_mul_ps(r, t2), _mm_set1_ps(0.19354346f));
+    r = _mm_add_ps(_mm_mul_ps(r, t2), _mm_set1_ps(-0.33262347f));
+    r = _mm_add_ps(_mm_mul_ps(r, t2), _mm_set1_ps(0.99997726f));
+    r = _mm_mul_ps(r, t);
+
+    mask = _mm_cmpgt_ps(ay, ax);
+    r = _mm_or_ps(_mm_and_ps(mask, _mm_sub_ps(_mm_set1_ps(M_PI / 2), r)),
+                  _mm_andnot_ps(mask, r));
+    /* x < 0, including -0 */
+    mask = _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(x), 31));
+    r = _mm_or_ps(_mm_and_ps(mask, _mm_sub_ps(_mm_set1_ps(M_PI), r)),
+                  _mm_andnot_ps(mask, r));
+    return _mm_or_ps(r, _mm_and_ps(sign, y));
+}
+
+SSE2 static void
+fbConicalIndicesSSE2(const SourcePictPtr pGradient, double rx, double ry,
+                     double cx, double cy, int n, int *ipos)
+{
+    __m128 lane = _mm_setr_ps(0, 1, 2, 3);
+
+    __m128 stepX = _mm_mul_ps(lane, _mm_set1_ps(cx));
+
+    __m128 stepY = _mm_mul_ps(lane, _mm_set1_ps(cy));
+
+    __m128 a = _mm_set1_ps(pGradient->conical.angle / (180. * 65536));
+
+    __m128 scale = _mm_set1_ps(1 / (2 * M_PI));
+
+    int i;
+
+    for (i = 0; i < n; i += 4) {
+        __m128 x = _mm_add_ps(_mm_set1_ps(rx + i * cx), stepX);
+
+        __m128 y = _mm_add_ps(_mm_set1_ps(ry + i * cy), stepY);
+
+        __m128 angle = _mm_add_ps(fbAtan2SSE2(y, x), a);
+
+        __m128i p = fbGradientIndexSSE2(_mm_mul_ps(angle, scale));
+
+        if (n - i >= 4) {
+            _mm_storeu_si128((__m128i *) (ipos + i), p);
+        }
+        else {
+            int tail[4];
+
+            _mm_storeu_si128((__m128i *) tail, p);
+            memcpy(ipos + i, tail, (n - i) * sizeof(int));
+        }
+    }
+}
+
+#endif                          /* FB_SIMD_X86 */
+
+#ifdef FB_SIMD_NEON
+
+/*
+ * NEON, eight pixels at a time, loaded one plane per channel so every
+ * operation is a plain byte vector op.  Channel 3 is alpha.
+ */
+
+static INLINE uint8x8_t
+fbMulNEON(uint8x8_t x, uint8x8_t a)
+{
+    uint16x8_t t = vmlal_u8(vdupq_n_u16(0x80), x, a);
+
+    return vshrn_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8);
+}
+
+static INLINE uint32x4_t
+fbDiv255NEON(uint32x4_t v, int green)
+{
+    if (green)
+        return vshrq_n_u32(vaddq_u32(vmulq_n_u32(v, 257),
+                                     vdupq_n_u32(0x8000)), 16);
+    v = vaddq_u32(v, vdupq_n_u32(0x80));
+    return vshrq_n_u32(vaddq_u32(v, vshrq_n_u32(v, 8)), 8);
+}
+
+static INLINE uint8x8_t
+fbAddMulNEON(uint8x8_t x, uint8x8_t a, uint8x8_t y, uint8x8_t b, int green)
+{
+    uint16x8_t p = vmull_u8(x, a);
+
+    uint16x8_t q = vmull_u8(y, b);
+
+    uint32x4_t lo = vaddl_u16(vget_low_u16(p), vget_low_u16(q));
+
+    uint32x4_t hi = vaddl_u16(vget_high_u16(p), vget_high_u16(q));
+
+    lo = fbDiv255NEON(lo, green);
+    hi = fbDiv255NEON(hi, green);
+    return vqmovn_u16(vcombine_u16(vqmovn_u32(lo), vqmovn_u32(hi)));
+}
+
+#define FbNeonCombineU(name, op)					\
+static FASTCALL void							\
+name(CARD32 *dest, const CARD32 *src, int width)			\
+{									\
+    CARD32 d[8], s[8];							\
+    uint8x8x4_t vs, vd;							\
+    int c;								\
+									\
+    for (; width > 0; width -= 8, dest += 8, src += 8) {		\
+        CARD32 *pd = dest;						\
+        const CARD32 *ps = src;						\
+									\
+        if (width < 8) {						\
+            memset(s, 0, sizeof(s));					\
+            memset(d, 0, sizeof(d));					\
+            memcpy(s, src, width * sizeof(CARD32));			\
+            memcpy(d, dest, width * sizeof(CARD32));			\
+            pd = d;							\
+            ps = s;							\
+        }								\
+        vs = vld4_u8((const uint8_t *) ps);				\
+        vd = vld4_u8((const uint8_t *) pd);				\
+        for (c = 0; c < 4; c++) {					\
+            op;								\
+        }								\
+        vst4_u8((uint8_t *) pd, vd);					\
+        if (pd == d)							\
+            memcpy(dest, d, width * sizeof(CARD32));			\
+    }									\
+}
+
+#define FbNeonCombineC(name, op)					\
+static FASTCALL void							\
+name(CARD32 *dest, CARD32 *src, CARD32 *mask, int width)		\
+{									\
+    CARD32 d[8], s[8], m[8];						\
+    uint8x8x4_t vs, vm, vd;						\
+    uint8x8_t da;							\
+    int c;								\
+									\
+    for (; width > 0; width -= 8, dest += 8, src += 8, mask += 8) {	\
+        CARD32 *pd = dest;						\
+        const CARD32 *ps = src, *pm = mask;				\
+									\
+        if (width < 8) {						\
+            memset(s, 0, sizeof(s));					\
+            memset(m, 0, sizeof(m));					\
+            memset(d, 0, sizeof(d));					\
+            memcpy(s, src, width * sizeof(CARD32));			\
+            memcpy(m, mask, width * sizeof(CARD32));			\
+            memcpy(d, dest, width * sizeof(CARD32));			\
+            pd = d;							\
+            ps = s;							\
+            pm = m;							\
+        }								\
+        vs = vld4_u8((const uint8_t *) ps);				\
+        vm = vld4_u8((const uint8_t *) pm);				\
+        vd = vld4_u8((const uint8_t *) pd);				\
+        da = vd.val[3];							\
+        for (c = 0; c < 4; c++) {					\
+            op;								\
+        }								\
+        vst4_u8((uint8_t *) pd, vd);					\
+        if (pd == d)							\
+            memcpy(dest, d, width * sizeof(CARD32));			\
+    }									\
+}
+
+static FASTCALL void
+fbCombineMaskUNEON(CARD32 *src, const CARD32 *mask, int width)
+{
+    CARD32 s[8], m[8];
+
+    uint8x8x4_t vs, vm;
+
+    int c;
+
+    for (; width > 0; width -= 8, src += 8, mask += 8) {
+        CARD32 *ps = src;
+
+        const CARD32 *pm = mask;
+
+        if (width < 8) {
+            memset(s, 0, sizeof(s));
+            memset(m, 0, sizeof(m));
+            memcpy(s, src, width * sizeof(CARD32));
+            memcpy(m, mask, width * sizeof(CARD32));
+            ps = s;
+            pm = m;
+        }
+        vs = vld4_u8((const uint8_t *) ps);
+        vm = vld4_u8((const uint8_t *) pm);
+        for (c = 0; c < 4; c++)
+            vs.val[c] = fbMulNEON(vs.val[c], vm.val[3]);
+        vst4_u8((uint8_t *) ps, vs);
+        if (ps == s)
+            memcpy(src, s, width * sizeof(CARD32));
+    }
+}
+
+/*
+ * Alpha is the last plane written, so operators reading the destination
+ * alpha still see the original value while the colour planes are done.
+ */
+FbNeonCombineU(fbCombineOverUNEON,
+               vd.val[c] = vqadd_u8(fbMulNEON(vd.val[c], vmvn_u8(vs.val[3])),
+                                    vs.val[c]))
+FbNeonCombineU(fbCombineOverReverseUNEON,
+               vd.val[c] = vqadd_u8(fbMulNEON(vs.val[c], vmvn_u8(vd.val[3])),
+                                    vd.val[c]))
+FbNeonCombineU(fbCombineInUNEON,
+               vd.val[c] = fbMulNEON(vs.val[c], vd.val[3]))
+FbNeonCombineU(fbCombineInReverseUNEON,
+               vd.val[c] = fbMulNEON(vd.val[c], vs.val[3]))
+FbNeonCombineU(fbCombineOutUNEON,
+               vd.val[c] = fbMulNEON(vs.val[c], vmvn_u8(vd.val[3])))
+FbNeonCombineU(fbCombineOutReverseUNEON,
+               vd.val[c] = fbMulNEON(vd.val[c], vmvn_u8(vs.val[3])))
+FbNeonCombineU(fbCombineAtopUNEON,
+               vd.val[c] = fbAddMulNEON(vs.val[c], vd.val[3], vd.val[c],
+                                        vmvn_u8(vs.val[3]), c == 1))
+FbNeonCombineU(fbCombineAtopReverseUNEON,
+               vd.val[c] = fbAddMulNEON(vs.val[c], vmvn_u8(vd.val[3]),
+                                        vd.val[c], vs.val[3], c == 1))
+FbNeonCombineU(fbCombineXorUNEON,
+               vd.val[c] = fbAddMulNEON(vs.val[c], vmvn_u8(vd.val[3]),
+                                        vd.val[c], vmvn_u8(vs.val[3]), c == 1))
+FbNeonCombineU(fbCombineAddUNEON,
+               vd.val[c] = vqadd_u8(vd.val[c], vs.val[c]))
+
+FbNeonCombineC(fbCombineSrcCNEON,
+               vd.val[c] = fbMulNEON(vs.val[c], vm.val[c]))
+/*
+ * fbCombineOverC leaves a pixel alone once its mask is empty, so the
+ * whole mask is worked out before any channel is written.
+ */
+static FASTCALL void
+fbCombineOverCNEON(CARD32 *dest, CARD32 *src, CARD32 *mask, int width)
+{
+    CARD32 d[8], s[8], m[8];
+
+    uint8x8x4_t vs, vm, vd;
+
+    uint8x8_t sa, keep;
+
+    int c;
+
+    for (; width > 0; width -= 8, dest += 8, src += 8, mask += 8) {
+        CARD32 *pd = dest;
+
+        const CARD32 *ps = src, *pm = mask;
+
+        if (width < 8) {
+            memset(s, 0, sizeof(s));
+            memset(m, 0, sizeof(m));
+            memset(d, 0, sizeof(d));
+            memcpy(s, src, width * sizeof(CARD32));
+            memcpy(m, mask, width * sizeof(CARD32));
+            memcpy(d, dest, width * sizeof(CARD32));
+            pd = d;
+            ps = s;
+            pm = m;
+        }
+        vs = vld4_u8((const uint8_t *) ps);
+        vm = vld4_u8((const uint8_t *) pm);
+        vd = vld4_u8((const uint8_t *) pd);
+        sa = vs.val[3];
+        keep = vdup_n_u8(0);
+        for (c = 0; c < 4; c++) {
+            vs.val[c] = fbMulNEON(vs.val[c], vm.val[c]);
+            vm.val[c] = fbMulNEON(vm.val[c], sa);
+            keep = vorr_u8(keep, vm.val[c]);
+        }
+        keep = vceq_u8(keep, vdup_n_u8(0));
+        for (c = 0; c < 4; c++)
+            vd.val[c] = vbsl_u8(keep, vd.val[c],
+                                vqadd_u8(fbMulNEON(vd.val[c],
+                                                   vmvn_u8(vm.val[c])),
+                                         vs.val[c]));
+        vst4_u8((uint8_t *) pd, vd);
+        if (pd == d)
+            memcpy(dest, d, width * sizeof(CARD32));
+    }
+}
+
+FbNeonCombineC(fbCombineOverReverseCNEON,
+               vd.val[c] = vbsl_u8(vceq_u8(da, vdup_n_u8(0)),
+                                   fbMulNEON(vs.val[c], vm.val[c]),
+                                   vqadd_u8(fbMulNEON(fbMulNEON(vs.val[c],
+                                                                vm.val[c]),
+                                                      vmvn_u8(da)),
+                                            vd.val[c])))
+FbNeonCombineC(fbCombineInCNEON,
+               vd.val[c] = fbMulNEON(fbMulNEON(vs.val[c], vm.val[c]), da))
+FbNeonCombineC(fbCombineOutCNEON,
+               vd.val[c] = fbMulNEON(fbMulNEON(vs.val[c], vm.val[c]),
+                                     vmvn_u8(da)))
+FbNeonCombineC(fbCombineAddCNEON,
+               vd.val[c] = vqadd_u8(vd.val[c],
+                                    fbMulNEON(vs.val[c], vm.val[c])))
+
+/*
+ * Scanline converters.  vld4/vst4 split pixels into channel planes, which
+ * also makes 24bpp a plain three plane load or store.
+ */
+
+static FASTCALL void
+fbFetch_x8r8g8b8NEON(const FbBits * bits, int x, int width, CARD32 *buffer,
+                     miIndexedPtr indexed)
+{
+    const CARD32 *pixel = (const CARD32 *) bits + x;
+
+    uint32x4_t alpha = vdupq_n_u32(0xff000000);
+
+    for (; width >= 4; width -= 4, pixel += 4, buffer += 4)
+        vst1q_u32(buffer, vorrq_u32(vld1q_u32(pixel), alpha));
+    while (width--)
+        *buffer++ = *pixel++ | 0xff000000;
+}
+
+static FASTCALL void
+fbStore_x8r8g8b8NEON(FbBits * bits, const CARD32 *values, int x, int width,
+                     miIndexedPtr indexed)
+{
+    CARD32 *pixel = (CARD32 *) bits + x;
+
+    uint32x4_t rgb = vdupq_n_u32(0xffffff);
+
+    for (; width >= 4; width -= 4, pixel += 4, values += 4)
+        vst1q_u32(pixel, vandq_u32(vld1q_u32(values), rgb));
+    while (width--)
+        *pixel++ = *values++ & 0xffffff;
+}
+
+static FASTCALL void
+fbFetch_a8NEON(const FbBits * bits, int x, int width, CARD32 *buffer,
+               miIndexedPtr indexed)
+{
+    const CARD8 *pixel = (const CARD8 *) bits + x;
+
+    uint8x8x4_t p;
+
+    p.val[0] = p.val[1] = p.val[2] = vdup_n_u8(0);
+    for (; width >= 8; width -= 8, pixel += 8, buffer += 8) {
+        p.val[3] = vld1_u8(pixel);
+        vst4_u8((uint8_t *) buffer, p);
+    }
+    while (width--)
+        *buffer++ = (*pixel++) << 24;
+}
+
+static FASTCALL void
+fbStore_a8NEON(FbBits * bits, const CARD32 *values, int x, int width,
+               miIndexedPtr indexed)
+{
+    CARD8 *pixel = (CARD8 *) bits + x;
+
+    for (; width >= 8; width -= 8, pixel += 8, values += 8)
+        vst1_u8(pixel, vld4_u8((const uint8_t *) values).val[3]);
+    while (width--)
+        *pixel++ = *values++ >> 24;
+}
+
+static FASTCALL void
+fbFetch_r5g6b5NEON(const FbBits * bits, int x, int width, CARD32 *buffer,
+                   miIndexedPtr indexed)
+{
+    const CARD16 *pixel = (const CARD16 *) bits + x;
+
+    uint8x8x4_t p;
+
+    p.val[3] = vdup_n_u8(0xff);
+    for (; width >= 8; width -= 8, pixel += 8, buffer += 8) {
+        uint16x8_t v = vld1q_u16(pixel);
+
+        uint8x8_t r = vshrn_n_u16(v, 8);
+
+        uint8x8_t g = vshrn_n_u16(v, 3);
+
+        uint8x8_t b = vmovn_u16(vshlq_n_u16(v, 3));
+
+        r = vand_u8(r, vdup_n_u8(0xf8));
+        g = vand_u8(g, vdup_n_u8(0xfc));
+        p.val[0] = vorr_u8(b, vshr_n_u8(b, 5));
+        p.val[1] = vorr_u8(g, vshr_n_u8(g, 6));
+        p.val[2] = vorr_u8(r, vshr_n_u8(r, 5));
+        vst4_u8((uint8_t *) buffer, p);
+    }
+    while (width--) {
+        CARD32 p = *pixel++;
+
+        CARD32 r = (((p) << 3) & 0xf8) |
+            (((p) << 5) & 0xfc00) | (((p) << 8) & 0xf80000);
+        r |= (r >> 5) & 0x70007;
+        r |= (r >> 6) & 0x300;
+        *buffer++ = 0xff000000 | r;
+    }
+}
+
+static FASTCALL void
+fbStore_r5g6b5NEON(FbBits * bits, const CARD32 *values, int x, int width,
+                   miIndexedPtr indexed)
+{
+    CARD16 *pixel = (CARD16 *) bits + x;
+
+    for (; width >= 8; width -= 8, pixel += 8, values += 8) {
+        uint8x8x4_t p = vld4_u8((const uint8_t *) values);
+
+        uint16x8_t v = vshll_n_u8(vand_u8(p.val[2], vdup_n_u8(0xf8)), 8);
+
+        v = vorrq_u16(v, vshll_n_u8(vand_u8(p.val[1], vdup_n_u8(0xfc)), 3));
+        v = vorrq_u16(v, vmovl_u8(vshr_n_u8(p.val[0], 3)));
+        vst1q_u16(pixel, v);
+    }
+    while (width--) {
+        CARD32 s = *values++;
+
+        *pixel++ = ((s >> 3) & 0x001f) |
+            ((s >> 5) & 0x07e0) | ((s >> 8) & 0xf800);
+    }
+}
+
+#if IMAGE_BYTE_ORDER == LSBFirst
+static FASTCALL void
+fbFetch_r8g8b8NEON(const FbBits * bits, int x, int width, CARD32 *buffer,
+                   miIndexedPtr indexed)
+{
+    const CARD8 *pixel = (const CARD8 *) bits + 3 * x;
+
+    uint8x8x3_t rgb;
+
+    uint8x8x4_t p;
+
+    p.val[3] = vdup_n_u8(0xff);
+    for (; width >= 8; width -= 8, pixel += 24, buffer += 8) {
+        rgb = vld3_u8(pixel);
+        p.val[0] = rgb.val[0];
+        p.val[1] = rgb.val[1];
+        p.val[2] = rgb.val[2];
+        vst4_u8((uint8_t *) buffer, p);
+    }
+    for (; width; width--, pixel += 3)
+        *buffer++ = Fetch24(pixel) | 0xff000000;
+}
+
+static FASTCALL void
+fbStore_r8g8b8NEON(FbBits * bits, const CARD32 *values, int x, int width,
+                   miIndexedPtr indexed)
+{
+    CARD8 *pixel = (CARD8 *) bits + 3 * x;
+
+    uint8x8x3_t rgb;
+
+    uint8x8x4_t p;
+
+    for (; width >= 8; width -= 8, pixel += 24, values += 8) {
+        p = vld4_u8((const uint8_t *) values);
+        rgb.val[0] = p.val[0];
+        rgb.val[1] = p.val[1];
+        rgb.val[2] = p.val[2];
+        vst3_u8(pixel, rgb);
+    }
+    for (; width; width--, pixel += 3) {
+        CARD32 v = *values++;
+
+        Store24(pixel, v);
+    }
+}
+#endif
+
+#endif                          /* FB_SIMD_NEON */
+
+/*
+ * Replace entries of the combiner tables with the best versions this
+ * CPU can run.  Only the plain Porter-Duff half of the tables is touched.
+ */
+void
+fbSimdCombineInit(CombineFuncU * combineU, CombineFuncC * combineC,
+                  CombineMaskU * combineMaskU)
+{
+#ifdef FB_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        *combineMaskU = fbCombineMaskUSSE2;
+        combineU[PictOpOver] = fbCombineOverUSSE2;
+        combineU[PictOpOverReverse] = fbCombineOverReverseUSSE2;
+        combineU[PictOpIn] = fbCombineInUSSE2;
+        combineU[PictOpInReverse] = fbCombineInReverseUSSE2;
+        combineU[PictOpOut] = fbCombineOutUSSE2;
+        combineU[PictOpOutReverse] = fbCombineOutReverseUSSE2;
+        combineU[PictOpAtop] = fbCombineAtopUSSE2;
+        combineU[PictOpAtopReverse] = fbCombineAtopReverseUSSE2;
+        combineU[PictOpXor] = fbCombineXorUSSE2;
+        combineU[PictOpAdd] = fbCombineAddUSSE2;
+        combineC[PictOpSrc] = fbCombineSrcCSSE2;
+        combineC[PictOpOver] = fbCombineOverCSSE2;
+        combineC[PictOpOverReverse] = fbCombineOverReverseCSSE2;
+        combineC[PictOpIn] = fbCombineInCSSE2;
+        combineC[PictOpOut] = fbCombineOutCSSE2;
+        combineC[PictOpAdd] = fbCombineAddCSSE2;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        *combineMaskU = fbCombineMaskUAVX2;
+        combineU[PictOpOver] = fbCombineOverUAVX2;
+        combineU[PictOpAdd] = fbCombineAddUAVX2;
+        combineC[PictOpOver] = fbCombineOverCAVX2;
+        combineC[PictOpAdd] = fbCombineAddCAVX2;
+    }
+#endif
+#ifdef FB_SIMD_NEON
+    *combineMaskU = fbCombineMaskUNEON;
+    combineU[PictOpOver] = fbCombineOverUNEON;
+    combineU[PictOpOverReverse] = fbCombineOverReverseUNEON;
+    combineU[PictOpIn] = fbCombineInUNEON;
+    combineU[PictOpInReverse] = fbCombineInReverseUNEON;
+    combineU[PictOpOut] = fbCombineOutUNEON;
+    combineU[PictOpOutReverse] = fbCombineOutReverseUNEON;
+    combineU[PictOpAtop] = fbCombineAtopUNEON;
+    combineU[PictOpAtopReverse] = fbCombineAtopReverseUNEON;
+    combineU[PictOpXor] = fbCombineXorUNEON;
+    combineU[PictOpAdd] = fbCombineAddUNEON;
+    combineC[PictOpSrc] = fbCombineSrcCNEON;
+    combineC[PictOpOver] = fbCombineOverCNEON;
+    combineC[PictOpOverReverse] = fbCombineOverReverseCNEON;
+    combineC[PictOpIn] = fbCombineInCNEON;
+    combineC[PictOpOut] = fbCombineOutCNEON;
+    combineC[PictOpAdd] = fbCombineAddCNEON;
+#endif
+}
+
+static fetchProc fbSimdFetch_x8r8g8b8;
+static fetchProc fbSimdFetch_r8g8b8;
+static fetchProc fbSimdFetch_r5g6b5;
+static fetchProc fbSimdFetch_a8;
+
+static storeProc fbSimdStore_x8r8g8b8;
+static storeProc fbSimdStore_r8g8b8;
+static storeProc fbSimdStore_r5g6b5;
+static storeProc fbSimdStore_a8;
+
+void
+fbSimdConvertInit(void)
+{
+#ifdef FB_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        fbSimdFetch_x8r8g8b8 = fbFetch_x8r8g8b8SSE2;
+        fbSimdFetch_r5g6b5 = fbFetch_r5g6b5SSE2;
+        fbSimdFetch_a8 = fbFetch_a8SSE2;
+        fbSimdStore_x8r8g8b8 = fbStore_x8r8g8b8SSE2;
+        fbSimdStore_r5g6b5 = fbStore_r5g6b5SSE2;
+        fbSimdStore_a8 = fbStore_a8SSE2;
+    }
+#if IMAGE_BYTE_ORDER == LSBFirst
+    if (__builtin_cpu_supports("ssse3")) {
+        fbSimdFetch_r8g8b8 = fbFetch_r8g8b8SSSE3;
+        fbSimdStore_r8g8b8 = fbStore_r8g8b8SSSE3;
+    }
+#endif
+#endif
+#ifdef FB_SIMD_NEON
+    fbSimdFetch_x8r8g8b8 = fbFetch_x8r8g8b8NEON;
+    fbSimdFetch_r5g6b5 = fbFetch_r5g6b5NEON;
+    fbSimdFetch_a8 = fbFetch_a8NEON;
+    fbSimdStore_x8r8g8b8 = fbStore_x8r8g8b8NEON;
+    fbSimdStore_r5g6b5 = fbStore_r5g6b5NEON;
+    fbSimdStore_a8 = fbStore_a8NEON;
+#if IMAGE_BYTE_ORDER == LSBFirst
+    fbSimdFetch_r8g8b8 = fbFetch_r8g8b8NEON;
+    fbSimdStore_r8g8b8 = fbStore_r8g8b8NEON;
+#endif
+#endif
+}
+
+/*
+ * Radial and conical position evaluators; the C versions in fbcompose.c
+ * stay in place when the CPU has nothing better.
+ */
+void
+fbSimdGradientInit(GradientIndexProc * radial, GradientIndexProc * conical)
+{
+#ifdef FB_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        *radial = fbRadialIndicesSSE2;
+        *conical = fbConicalIndicesSSE2;
+    }
+#endif
+}
+
+/*
+ * Vector converters for the formats that show up as 16 and 24 bpp frame
+ * buffers and as glyph masks; NULL leaves fbcompose.c to the C ones.
+ */
+fetchProc
+fbSimdFetchProc(CARD32 format)
+{
+    switch (format) {
+    case PICT_x8r8g8b8:
+        return fbSimdFetch_x8r8g8b8;
+    case PICT_r8g8b8:
+        return fbSimdFetch_r8g8b8;
+    case PICT_r5g6b5:
+        return fbSimdFetch_r5g6b5;
+    case PICT_a8:
+        return fbSimdFetch_a8;
+    }
+    return NULL;
+}
+
+storeProc
+fbSimdStoreProc(CARD32 format)
+{
+    switch (format) {
+    case PICT_x8r8g8b8:
+        return fbSimdStore_x8r8g8b8;
+    case PICT_r8g8b8:
+        return fbSimdStore_r8g8b8;
+    case PICT_r5g6b5:
+        return fbSimdStore_r5g6b5;
+    case PICT_a8:
+        return fbSimdStore_a8;
+    }
+    return NULL;
+}
@@ -33,64 +33,38 @@
 #include "renderedge.h"
 #include "fbpict.h"
 
-void
-fbAddTraps(PicturePtr pPicture,
-           INT16 x_off, INT16 y_off, int ntrap, xTrap * traps)
+/*
+ * Point an FbSpanBits at the pixels of an alpha picture, folding the
+ * drawable offset into x_off, y_off.  Only a1, a4 and a8 can be swept
+ * into; like fbRasterizeEdges, anything deeper is left alone.
+ */
+static Bool
+fbSpanBitsInit(PicturePtr pPicture, FbSpanBitsPtr dst, int *x_off, int *y_off)
 {
-    FbBits *buf;
-
-    int bpp;
-    int width;
-    int stride;
-    int height;
     int pxoff, pyoff;
 
-    xFixed x_off_fixed;
-    xFixed y_off_fixed;
-
-    RenderEdge l, r;
-
-    xFixed t, b;
-
-    fbGetDrawable(pPicture->pDrawable, buf, stride, bpp, pxoff, pyoff);
+    fbGetDrawable(pPicture->pDrawable, dst->bits, dst->stride, dst->bpp,
+                  pxoff, pyoff);
+    if (dst->bpp != 1 && dst->bpp != 4 && dst->bpp != 8)
+        return FALSE;
+    *x_off += pxoff;
+    *y_off += pyoff;
+    return TRUE;
+}
 
-    width = pPicture->pDrawable->width;
-    height = pPicture->pDrawable->height;
-    x_off += pxoff;
-    y_off += pyoff;
+void
+fbAddTraps(PicturePtr pPicture,
+           INT16 x_off, INT16 y_off, int ntrap, xTrap * traps)
+{
+    FbSpanBitsRec dst;
 
-    x_off_fixed = IntToxFixed(x_off);
-    y_off_fixed = IntToxFixed(y_off);
+    int xoff = x_off, yoff = y_off;
 
-    while (ntrap--) {
-        t = traps->top.y + y_off_fixed;
-        if (t < 0)
-            t = 0;
-        t = RenderSampleCeilY(t, bpp);
-
-        b = traps->bot.y + y_off_fixed;
-        if (xFixedToInt(b) >= height)
-            b = IntToxFixed(height) - 1;
-        b = RenderSampleFloorY(b, bpp);
-
-        if (b >= t) {
-            /* initialize edge walkers */
-            RenderEdgeInit(&l, bpp, t,
-                           traps->top.l + x_off_fixed,
-                           traps->top.y + y_off_fixed,
-                           traps->bot.l + x_off_fixed,
-                           traps->bot.y + y_off_fixed);
-
-            RenderEdgeInit(&r, bpp, t,
-                           traps->top.r + x_off_fixed,
-                           traps->top.y + y_off_fixed,
-                           traps->bot.r + x_off_fixed,
-                           traps->bot.y + y_off_fixed);
-
-            fbRasterizeEdges(buf, bpp, width, stride, &l, &r, t, b);
-        }
-        traps++;
-    }
+    if (!fbSpanBitsInit(pPicture, &dst, &xoff, &yoff))
+        return;
+    RenderSweepTraps(dst.bpp, pPicture->pDrawable->width,
+                     pPicture->pDrawable->height, xoff, yoff,
+                     ntrap, traps, fbRasterizeSpan, &dst);
 }
 
 void
@@ -144,96 +118,43 @@ fbRasterizeTrapezoid(PicturePtr pPicture,
     }
 }
 
-static int
-_GreaterY(xPointFixed * a, xPointFixed * b)
+void
+fbAddTriangles(PicturePtr pPicture,
+               INT16 x_off, INT16 y_off, int ntri, xTriangle * tris)
 {
-    if (a->y == b->y)
-        return a->x > b->x;
-    return a->y > b->y;
+    FbSpanBitsRec dst;
+
+    int xoff = x_off, yoff = y_off;
+
+    if (!fbSpanBitsInit(pPicture, &dst, &xoff, &yoff))
+        return;
+    RenderSweepTriangles(dst.bpp, pPicture->pDrawable->width,
+                         pPicture->pDrawable->height, xoff, yoff,
+                         ntri, tris, fbRasterizeSpan, &dst);
 }
 
 /*
- * Note that the definition of this function is a bit odd because
- * of the X coordinate space (y increasing downwards).
+ * Solid alpha added to an alpha picture sweeps every trapezoid straight
+ * into the destination at once, rather than rasterizing them one at a
+ * time; everything else is left to mi.
  */
-static int
-_Clockwise(xPointFixed * ref, xPointFixed * a, xPointFixed * b)
+void
+fbTrapezoids(CARD8 op,
+             PicturePtr pSrc,
+             PicturePtr pDst,
+             PictFormatPtr maskFormat,
+             INT16 xSrc, INT16 ySrc, int ntrap, xTrapezoid * traps)
 {
-    xPointFixed ad, bd;
+    if (op == PictOpAdd && miIsSolidAlpha(pSrc)) {
+        FbSpanBitsRec dst;
 
-    ad.x = a->x - ref->x;
-    ad.y = a->y - ref->y;
-    bd.x = b->x - ref->x;
-    bd.y = b->y - ref->y;
-
-    return ((xFixed_32_32) bd.y * ad.x - (xFixed_32_32) ad.y * bd.x) < 0;
-}
+        int xoff = 0, yoff = 0;
 
-/* FIXME -- this could be made more efficient */
-void
-fbAddTriangles(PicturePtr pPicture,
-               INT16 x_off, INT16 y_off, int ntri, xTriangle * tris)
-{
-    xPointFixed *top, *left, *right, *tmp;
-
-    xTrapezoid trap;
-
-    for (; ntri; ntri--, tris++) {
-        top = &tris->p1;
-        left = &tris->p2;
-        right = &tris->p3;
-        if (_GreaterY(top, left)) {
-            tmp = left;
-            left = top;
-            top = tmp;
-        }
-        if (_GreaterY(top, right)) {
-            tmp = right;
-            right = top;
-            top = tmp;
-        }
-        if (_Clockwise(top, right, left)) {
-            tmp = right;
-            right = left;
-            left = tmp;
-        }
-
-        /*
-         * Two cases:
-         *
-         *              +               +
-         *             / \             / \
-         *            /   \           /   \
-         *           /     +         +     \
-         *      /    --           --    \
-         *     /   --               --   \
-         *    / ---                   --- \
-         *       +--                         --+
-         */
-
-        trap.top = top->y;
-        trap.left.p1 = *top;
-        trap.left.p2 = *left;
-        trap.right.p1 = *top;
-        trap.right.p2 = *right;
-        if (right->y < left->y)
-            trap.bottom = right->y;
-        else
-            trap.bottom = left->y;
-        fbRasterizeTrapezoid(pPicture, &trap, x_off, y_off);
-        if (right->y < left->y) {
-            trap.top = right->y;
-            trap.bottom = left->y;
-            trap.right.p1 = *right;
-            trap.right.p2 = *left;
-        }
-        else {
-            trap.top = left->y;
-            trap.bottom = right->y;
-            trap.left.p1 = *left;
-            trap.left.p2 = *right;
-        }
-        fbRasterizeTrapezoid(pPicture, &trap, x_off, y_off);
+        if (fbSpanBitsInit(pDst, &dst, &xoff, &yoff) &&
+            RenderSweepTrapezoids(dst.bpp, pDst->pDrawable->width,
+                                  pDst->pDrawable->height, xoff, yoff,
+                                  ntrap, traps, fbRasterizeSpan, &dst))
+            return;
     }
+    miTrapezoids(op, pSrc, pDst, maskFormat, xSrc, ySrc, ntrap, traps);
 }
-
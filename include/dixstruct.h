@@ -78,6 +78,19 @@ typedef struct _saveSet {
 #define SaveSetAssignToRoot(ss,tr)  ((ss).toRoot = (tr))
 #define SaveSetAssignRemap(ss,rm)  ((ss).remap = (rm))
 
+/*
+ * Request accounting, kept for every client and reported through
+ * X-Resource or dumped on SIGUSR2.  Times are in microseconds.
+ */
+typedef struct _ClientStats {
+    CARD32	requests[256];		/* by major opcode */
+    CARD64	time[256];		/* in the handlers, by major opcode */
+    CARD64	bytesRead;
+    CARD64	bytesWritten;
+    CARD64	blockedTime;		/* with output the client won't take */
+    CARD64	blockedSince;		/* 0 unless write blocked now */
+} ClientStatsRec;
+
 typedef struct _Client {
     int         index;
     Mask        clientAsMask;
@@ -116,32 +129,40 @@ typedef struct _Client {
 		int *		/* num */);
 #ifdef SMART_SCHEDULE
     int	    smart_priority;
-    long    smart_start_tick;
-    long    smart_stop_tick;
-    long    smart_check_tick;
+    CARD64  smart_start_tick;	/* all in microseconds */
+    CARD64  smart_stop_tick;
+    CARD64  smart_check_tick;
+    CARD64  smart_time;		/* spent dispatching the client */
 #endif
+    ClientStatsRec stats;
 }           ClientRec;
 
 #ifdef SMART_SCHEDULE
 /*
- * Scheduling interface
+ * Scheduling interface.  SmartScheduleTime is the monotonic clock in
+ * microseconds as last read by Dispatch; the slices are in milliseconds.
  */
-extern long SmartScheduleTime;
+extern CARD64 SmartScheduleTime;
 extern long SmartScheduleInterval;
 extern long SmartScheduleSlice;
 extern long SmartScheduleMaxSlice;
-extern unsigned long SmartScheduleIdleCount;
 extern Bool SmartScheduleDisable;
-extern Bool SmartScheduleIdle;
-extern Bool SmartScheduleTimerStopped;
-Bool SmartScheduleStartTimer(void);
 #define SMART_MAX_PRIORITY  (20)
 #define SMART_MIN_PRIORITY  (-20)
 
-Bool SmartScheduleInit(void);
+#define SMART_USEC(ms)	((CARD64) (ms) * 1000)
 
 #endif
 
+void ClientStatsDump(void);
+
+/* dispatch tracing, see dix/trace.c */
+Bool DispatchTraceInit(void);
+void DispatchTrace(int /*client*/, CARD32 /*sequence*/, int /*major*/,
+		   int /*minor*/, int /*bytes*/, CARD64 /*start*/,
+		   CARD64 /*end*/);
+void DispatchTraceDump(void);
+
 /* This prototype is used pervasively in Xext, dix */
 #define DISPATCH_PROC(func) int func(ClientPtr /* client */)
 
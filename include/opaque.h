@@ -71,5 +71,13 @@ extern Bool whiteRoot;
 
 extern Bool CoreDump;
 
+extern Bool DispatchTraceEnabled;
+extern char *DispatchTraceFile;
+extern Bool DispatchTraceBinary;
+extern int DispatchTraceSize;
+
+/* -tracesize is capped here, 32MB of records */
+#define DISPATCH_TRACE_MAX_SIZE	(1 << 20)
+
 
 #endif /* OPAQUE_H */
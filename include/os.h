@@ -160,8 +160,12 @@ void MakeClientGrabPervious(ClientPtr /*client*/);
 
 void AvailableClientInput(ClientPtr /* client */);
 
+CARD64 ClientWriteBlockedTime(ClientPtr /* client */);
+
 CARD32 XFONT_LTO GetTimeInMillis(void);
 
+CARD64 GetTimeInMicros(void);
+
 void AdjustWaitForDelay(
     pointer /*waitTime*/,
     unsigned long /*newdelay*/);
@@ -197,6 +201,12 @@ SIGVAL AutoResetServer(int /*sig*/);
 
 SIGVAL GiveUp(int /*sig*/);
 
+SIGVAL DispatchStatsRequest(int /*sig*/);
+
+extern volatile char ClientStatsPending;
+
+extern volatile char DispatchTracePending;
+
 void UseMsg(void);
 
 void ProcessCommandLine(int /*argc*/, char* /*argv*/[]);
@@ -208,6 +218,14 @@ XFONT_LTO int set_font_authorizations(
 
 void OsInitAllocator(void);
 
+pointer ScratchAlloc(unsigned long /*size*/);
+
+pointer ScratchRealloc(pointer /*ptr*/, unsigned long /*size*/);
+
+void ScratchFree(pointer /*ptr*/);
+
+void ScratchReset(void);
+
 typedef SIGVAL (*OsSigHandlerPtr)(int /* sig */);
 
 OsSigHandlerPtr OsSignal(int /* sig */, OsSigHandlerPtr /* handler */);
@@ -32,6 +32,8 @@
 extern int KdTsPhyScreen;
 
 const char *fbdevDevicePath = NULL;
+Bool fbdevPageFlip;
+Bool fbdevVsync;
 
 static Bool fbdevMapFramebuffer(KdScreenInfo * screen);
 
@@ -75,6 +77,8 @@ static Bool fbdevInitialize(KdCardInfo * card, FbdevPriv * priv)
 	}
 	off = (unsigned long) priv->fix.smem_start % (unsigned long) getpagesize();
 	priv->fb = priv->fb_base + off;
+	priv->flip = FALSE;
+	REGION_NULL(&priv->flipDamage);
 	return TRUE;
 }
 
@@ -185,7 +189,14 @@ static Bool fbdevScreenInitialize(KdScreenInfo * screen, FbdevScrPriv * scrpriv)
 	var.bits_per_pixel = screen->fb.depth;
 	var.nonstd = 0;
 	var.grayscale = 0;
+	var.yoffset = 0;
 
+	if (fbdevPageFlip && var.yres_virtual < var.yres * 2) {
+		var.yres_virtual = var.yres * 2;
+		k = ioctl(priv->fd, FBIOPUT_VSCREENINFO, &var);
+		if (k < 0)
+			var.yres_virtual = var.yres;
+	}
 	k = ioctl(priv->fd, FBIOPUT_VSCREENINFO, &var);
 
 	if (k < 0) {
@@ -207,6 +218,13 @@ static Bool fbdevScreenInitialize(KdScreenInfo * screen, FbdevScrPriv * scrpriv)
 	if (!priv->fix.line_length)
 		priv->fix.line_length = (priv->var.xres_virtual * depth + 7) / 8;
 
+	priv->flip = fbdevPageFlip &&
+	    priv->fix.type == FB_TYPE_PACKED_PIXELS &&
+	    priv->var.yres_virtual >= priv->var.yres * 2 &&
+	    priv->fix.smem_len >= priv->fix.line_length * priv->var.yres * 2;
+	if (fbdevPageFlip && !priv->flip)
+		ErrorF("Frame buffer too small for page flipping\n");
+
 	switch (priv->fix.visual) {
 	case FB_VISUAL_PSEUDOCOLOR:
 		if (gray) {
@@ -307,10 +325,57 @@ static void *fbdevWindowLinear(ScreenPtr pScreen,
 
 	if (!pScreenPriv->enabled)
 		return 0;
+	/* with page flipping, draw into whichever page is not scanned out */
+	if (priv->flip && !priv->var.yoffset)
+		row += priv->var.yres;
 	*size = priv->fix.line_length;
 	return (CARD8 *) priv->fb + row * priv->fix.line_length + offset;
 }
 
+/*
+ * The hidden page is one frame behind: it is missing whatever went to
+ * the visible page last time.  Add that to the new damage before the
+ * flush starts, so the cursor gets painted into all of it too.
+ */
+static void fbdevPrepareFlip(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+	KdScreenPriv(pScreen);
+	FbdevPriv *priv = pScreenPriv->card->driver;
+	RegionPtr damage = shadowDamage(pBuf);
+	RegionRec current;
+
+	REGION_NULL(&current);
+	REGION_COPY(&current, damage);
+	REGION_UNION(damage, damage, &priv->flipDamage);
+	REGION_UNINIT(&priv->flipDamage);
+	priv->flipDamage = current;
+}
+
+/* Copy the damage to the hidden page, then pan over to it */
+static void fbdevUpdateFlip(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+	KdScreenPriv(pScreen);
+	FbdevPriv *priv = pScreenPriv->card->driver;
+	FbdevScrPriv *scrpriv = pScreenPriv->screen->driver;
+
+	(*scrpriv->update) (pScreen, pBuf);
+
+	if (!pScreenPriv->enabled)
+		return;
+	priv->var.yoffset = priv->var.yoffset ? 0 : priv->var.yres;
+#ifdef FBIO_WAITFORVSYNC
+	if (fbdevVsync) {
+		__u32 crtc = 0;
+
+		ioctl(priv->fd, FBIO_WAITFORVSYNC, &crtc);
+	}
+#endif
+	if (ioctl(priv->fd, FBIOPAN_DISPLAY, &priv->var) < 0) {
+		perror("FBIOPAN_DISPLAY");
+		priv->var.yoffset = priv->var.yoffset ? 0 : priv->var.yres;
+	}
+}
+
 static Bool fbdevMapFramebuffer(KdScreenInfo * screen)
 {
 	FbdevScrPriv *scrpriv = screen->driver;
@@ -318,7 +383,8 @@ static Bool fbdevMapFramebuffer(KdScreenInfo * screen)
 	FbdevPriv *priv = screen->card->driver;
 
 	if (scrpriv->randr != RR_Rotate_0 ||
-		priv->fix.type != FB_TYPE_PACKED_PIXELS)
+		priv->fix.type != FB_TYPE_PACKED_PIXELS || priv->flip ||
+		screen->shadowCursor)
 		scrpriv->shadow = TRUE;
 	else
 		scrpriv->shadow = FALSE;
@@ -425,7 +491,17 @@ static Bool fbdevSetShadow(ScreenPtr pScreen)
 			update = shadowUpdateRotatePacked;
 	else
 		update = shadowUpdatePacked;
-	return KdShadowSet(pScreen, scrpriv->randr, update, window);
+
+	if (!priv->flip)
+		return KdShadowSet(pScreen, scrpriv->randr, update, window);
+
+	scrpriv->update = update;
+	/* each flush ends in a pan, it can't be split across threads */
+	if (!KdShadowSetSerial(pScreen, scrpriv->randr, fbdevUpdateFlip,
+			       window))
+		return FALSE;
+	shadowSetPrepare(pScreen, fbdevPrepareFlip);
+	return TRUE;
 }
 
 static Bool fbdevRandRGetInfo(ScreenPtr pScreen, Rotation * rotations)
@@ -644,6 +720,19 @@ Bool fbdevEnable(ScreenPtr pScreen)
 
 	priv->var.activate = FB_ACTIVATE_NOW | FB_CHANGE_CMAP_VBL;
 
+	/* the console owned both pages meanwhile, start over on page 0 */
+	if (priv->flip) {
+		BoxRec box;
+
+		box.x1 = 0;
+		box.y1 = 0;
+		box.x2 = pScreen->width;
+		box.y2 = pScreen->height;
+		REGION_UNINIT(&priv->flipDamage);
+		REGION_INIT(&priv->flipDamage, &box, 1);
+		priv->var.yoffset = 0;
+	}
+
 	/* display it on the LCD */
 	k = ioctl(priv->fd, FBIOPUT_VSCREENINFO, &priv->var);
 	if (k < 0) {
@@ -712,6 +801,7 @@ void fbdevCardFini(KdCardInfo * card)
 
 	munmap(priv->fb_base, priv->fix.smem_len);
 	close(priv->fd);
+	REGION_UNINIT(&priv->flipDamage);
 	free(priv);
 }
 
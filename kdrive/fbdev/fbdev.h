@@ -40,14 +40,19 @@ typedef struct _fbdevPriv {
 	int fd;
 	char *fb;
 	char *fb_base;
+	Bool flip;		/* two pages, shadow flushes to the hidden one */
+	RegionRec flipDamage;	/* damage last copied to the visible page */
 } FbdevPriv;
 
 typedef struct _fbdevScrPriv {
 	Rotation randr;
 	Bool shadow;
+	ShadowUpdateProc update;
 } FbdevScrPriv;
 
 extern const char *fbdevDevicePath;
+extern Bool fbdevPageFlip;
+extern Bool fbdevVsync;
 
 Bool fbdevCardInit(KdCardInfo * card);
 
@@ -76,6 +76,9 @@ void ddxUseMsg(void)
 	ErrorF("\nXfbdev Device Usage:\n");
 	ErrorF
 	    ("-fb path         Framebuffer device to use. Defaults to /dev/fb0\n");
+	ErrorF
+	    ("-flip            Double buffer with FBIOPAN_DISPLAY when the device has room\n");
+	ErrorF("-vsync           Wait for vertical retrace before flipping\n");
 	ErrorF("\n");
 }
 
@@ -96,5 +99,15 @@ int ddxProcessArgument(int argc, char **argv, int i)
 		exit(1);
 	}
 
+	if (!strcmp(argv[i], "-flip")) {
+		fbdevPageFlip = TRUE;
+		return 1;
+	}
+
+	if (!strcmp(argv[i], "-vsync")) {
+		fbdevVsync = TRUE;
+		return 1;
+	}
+
 	return KdProcessArgument(argc, argv, i);
 }
@@ -64,6 +64,9 @@ int kdVirtualTerminal = -1;
 Bool kdSwitchPending;
 static const char *kdSwitchCmd;
 static DDXPointRec kdOrigin;
+int kdShadowThreads;
+int kdShadowRate;
+Bool kdInputThread;
 
 /*
  * Carry arguments from InitOutput through driver initialization
@@ -179,6 +182,8 @@ void KdDisableScreen(ScreenPtr pScreen)
 		(*pScreenPriv->card->cfuncs->disableCursor) (pScreen);
 	if (pScreenPriv->card->cfuncs->dpms)
 		(*pScreenPriv->card->cfuncs->dpms) (pScreen, KD_DPMS_NORMAL);
+	if (pScreenPriv->screen->fb.shadow)
+		shadowSync(pScreen);
 	pScreenPriv->enabled = FALSE;
 	if (pScreenPriv->card->cfuncs->disable)
 		(*pScreenPriv->card->cfuncs->disable) (pScreen);
@@ -575,6 +580,13 @@ void KdUseMsg(void)
 	    ("-rawcoord        Don't transform pointer coordinates on rotation\n");
 	ErrorF("-dumb            Disable hardware acceleration\n");
 	ErrorF("-softCursor      Force software cursor\n");
+	ErrorF
+	    ("-shadowthreads N Flush the shadow frame buffer with N threads\n");
+	ErrorF
+	    ("-shadowrate HZ   Flush the shadow frame buffer at most HZ times a second\n");
+#ifdef INPUT_THREAD
+	ErrorF("-inputthread     Read input devices on a thread of their own\n");
+#endif
 	ErrorF
 	    ("-origin X,Y      Locates the next screen in the the virtual screen (Xinerama)\n");
 	ErrorF
@@ -636,6 +648,26 @@ int KdProcessArgument(int argc, char **argv, int i)
 		kdSoftCursor = TRUE;
 		return 1;
 	}
+	if (!strcmp(argv[i], "-shadowthreads")) {
+		if ((i + 1) < argc)
+			kdShadowThreads = atoi(argv[i + 1]);
+		else
+			UseMsg();
+		return 2;
+	}
+	if (!strcmp(argv[i], "-shadowrate")) {
+		if ((i + 1) < argc)
+			kdShadowRate = atoi(argv[i + 1]);
+		else
+			UseMsg();
+		return 2;
+	}
+#ifdef INPUT_THREAD
+	if (!strcmp(argv[i], "-inputthread")) {
+		kdInputThread = TRUE;
+		return 1;
+	}
+#endif
 	if (!strcmp(argv[i], "-origin")) {
 		if ((i + 1) < argc) {
 			char *x = argv[i + 1];
@@ -1031,7 +1063,11 @@ static Bool KdScreenInit(int index, ScreenPtr pScreen, int argc, char **argv)
 	    || !(*card->cfuncs->initCursor) (pScreen)) {
 		/* Use MI for cursor display and event queueing. */
 		screen->softCursor = TRUE;
-		miDCInitialize(pScreen, &kdPointerScreenFuncs);
+		/* with a shadow, leave the cursor to the flush */
+		screen->shadowCursor = screen->fb.shadow &&
+		    shadowCursorInit(pScreen, &kdPointerScreenFuncs);
+		if (!screen->shadowCursor)
+			miDCInitialize(pScreen, &kdPointerScreenFuncs);
 	}
 
 	if (!fbCreateDefColormap(pScreen)) {
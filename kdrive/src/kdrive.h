@@ -101,6 +101,7 @@ typedef struct _KdScreenInfo {
 	int subpixel_order;
 	Bool dumb;
 	Bool softCursor;
+	Bool shadowCursor;	/* cursor drawn by the shadow flush */
 	int mynum;
 	DDXPointRec origin;
 	KdFrameBuffer fb;
@@ -268,6 +269,9 @@ extern Bool kdSwitchPending;
 extern Bool kdDisableZaphod;
 extern Bool kdDontZap;
 extern int kdVirtualTerminal;
+extern int kdShadowThreads;
+extern int kdShadowRate;
+extern Bool kdInputThread;
 extern const KdOsFuncs *kdOsFuncs;
 
 #define KdGetScreenPriv(pScreen) ((KdPrivScreenPtr) \
@@ -411,6 +415,10 @@ Bool
 KdShadowSet(ScreenPtr pScreen, int randr, ShadowUpdateProc update,
 	    ShadowWindowProc window);
 
+Bool
+KdShadowSetSerial(ScreenPtr pScreen, int randr, ShadowUpdateProc update,
+		  ShadowWindowProc window);
+
 void KdShadowUnset(ScreenPtr pScreen);
 
 /* function prototypes to be implemented by the drivers */
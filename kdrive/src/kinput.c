@@ -35,6 +35,13 @@
 #include "kkeymap.h"
 #include <signal.h>
 #include <stdio.h>
+#ifdef INPUT_THREAD
+#include <pthread.h>
+#include <poll.h>
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+#endif
 
 static DeviceIntPtr pKdKeyboard, pKdPointer;
 
@@ -101,6 +108,142 @@ static KdInputFd kdInputFds[KD_MAX_INPUT_FDS];
 static int kdNumInputFds;
 static int kdInputTypeSequence;
 
+#ifdef INPUT_THREAD
+
+/*
+ * Input thread.
+ *
+ * With -inputthread the registered fds are read on a thread of their
+ * own instead of from SIGIO.  Where the dispatch thread would block
+ * SIGIO it takes kdInputMutex instead, which the thread holds while it
+ * runs the read functions, so those keep seeing the same world they did
+ * from a signal handler.  Events reach the dispatch thread through the
+ * mi event queue, which needs no lock; the thread then pokes kdWakeFd,
+ * an enabled device, so a sleeping server gets round to
+ * ProcessInputEvents.  kdControlFd tells the thread the set of fds
+ * changed.
+ */
+
+static Bool kdInputThreadRunning;
+static pthread_t kdInputThreadId;
+static pthread_mutex_t kdInputMutex;
+static int kdInputBlocked;	/* dispatch thread's hold on kdInputMutex */
+static int kdWakeFd[2] = { -1, -1 };
+static int kdControlFd[2] = { -1, -1 };
+
+static void KdSignalFd(int *fds)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+	uint64_t one = 1;
+
+	(void)write(fds[1], &one, sizeof(one));
+#else
+	char c = 0;
+
+	(void)write(fds[1], &c, 1);
+#endif
+}
+
+static void KdDrainFd(int *fds)
+{
+	char buf[64];
+
+	while (read(fds[0], buf, sizeof(buf)) > 0)
+		;
+}
+
+static Bool KdOpenSignalFd(int *fds)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+	fds[0] = fds[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	return fds[0] >= 0;
+#else
+	if (pipe(fds) < 0)
+		return FALSE;
+	fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+	fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+	return TRUE;
+#endif
+}
+
+static void *KdInputThread(void *arg)
+{
+	struct pollfd pfd[KD_MAX_INPUT_FDS + 1];
+	int i, j, n;
+
+	for (;;) {
+		pthread_mutex_lock(&kdInputMutex);
+		n = 0;
+		if (kdInputEnabled)
+			for (i = 0; i < kdNumInputFds; i++) {
+				pfd[n].fd = kdInputFds[i].fd;
+				pfd[n].events = POLLIN;
+				n++;
+			}
+		pthread_mutex_unlock(&kdInputMutex);
+		pfd[n].fd = kdControlFd[0];
+		pfd[n].events = POLLIN;
+
+		if (poll(pfd, n + 1, -1) <= 0)
+			continue;
+		if (pfd[n].revents) {
+			KdDrainFd(kdControlFd);
+			continue;
+		}
+
+		pthread_mutex_lock(&kdInputMutex);
+		/* the fds may have changed while we slept; read those still here */
+		for (j = 0; j < n; j++) {
+			if (!(pfd[j].revents & (POLLIN | POLLERR | POLLHUP)))
+				continue;
+			for (i = 0; kdInputEnabled && i < kdNumInputFds; i++)
+				if (kdInputFds[i].fd == pfd[j].fd) {
+					(*kdInputFds[i].read) (kdInputFds[i].fd,
+							       kdInputFds[i].closure);
+					break;
+				}
+		}
+		pthread_mutex_unlock(&kdInputMutex);
+		KdSignalFd(kdWakeFd);
+	}
+	return NULL;
+}
+
+static void KdStartInputThread(void)
+{
+	pthread_mutexattr_t attr;
+	sigset_t set, old;
+
+	if (!KdOpenSignalFd(kdWakeFd))
+		return;
+	if (!KdOpenSignalFd(kdControlFd)) {
+		close(kdWakeFd[0]);
+		if (kdWakeFd[1] != kdWakeFd[0])
+			close(kdWakeFd[1]);
+		return;
+	}
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&kdInputMutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+
+	/* signals stay with the dispatch thread */
+	sigfillset(&set);
+	pthread_sigmask(SIG_SETMASK, &set, &old);
+	kdInputThreadRunning =
+	    pthread_create(&kdInputThreadId, NULL, KdInputThread, NULL) == 0;
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (!kdInputThreadRunning) {
+		ErrorF("Failed to start input thread, using SIGIO\n");
+		return;
+	}
+	AddEnabledDevice(kdWakeFd[0]);
+}
+
+#endif
+
 static void KdSigio(int sig)
 {
 	int i;
@@ -113,6 +256,13 @@ static void KdBlockSigio(void)
 {
 	sigset_t set;
 
+#ifdef INPUT_THREAD
+	if (kdInputThreadRunning) {
+		pthread_mutex_lock(&kdInputMutex);
+		kdInputBlocked++;
+		return;
+	}
+#endif
 	sigemptyset(&set);
 	sigaddset(&set, SIGIO);
 	sigprocmask(SIG_BLOCK, &set, 0);
@@ -122,6 +272,15 @@ static void KdUnblockSigio(void)
 {
 	sigset_t set;
 
+#ifdef INPUT_THREAD
+	if (kdInputThreadRunning) {
+		if (kdInputBlocked) {
+			kdInputBlocked--;
+			pthread_mutex_unlock(&kdInputMutex);
+		}
+		return;
+	}
+#endif
 	sigemptyset(&set);
 	sigaddset(&set, SIGIO);
 	sigprocmask(SIG_UNBLOCK, &set, 0);
@@ -160,6 +319,10 @@ static void KdNonBlockFd(int fd)
 
 	flags = fcntl(fd, F_GETFL);
 	flags |= FASYNC | NOBLOCK;
+#ifdef INPUT_THREAD
+	if (kdInputThreadRunning)
+		flags &= ~FASYNC;
+#endif
 	fcntl(fd, F_SETFL, flags);
 }
 
@@ -170,6 +333,13 @@ static void KdAddFd(int fd)
 	sigset_t set;
 
 	kdnFds++;
+#ifdef INPUT_THREAD
+	if (kdInputThreadRunning) {
+		KdNonBlockFd(fd);
+		KdSignalFd(kdControlFd);
+		return;
+	}
+#endif
 	fcntl(fd, F_SETOWN, getpid());
 	KdNonBlockFd(fd);
 	AddEnabledDevice(fd);
@@ -191,6 +361,15 @@ static void KdRemoveFd(int fd)
 	int flags;
 
 	kdnFds--;
+#ifdef INPUT_THREAD
+	if (kdInputThreadRunning) {
+		flags = fcntl(fd, F_GETFL);
+		flags &= ~NOBLOCK;
+		fcntl(fd, F_SETFL, flags);
+		KdSignalFd(kdControlFd);
+		return;
+	}
+#endif
 	RemoveEnabledDevice(fd);
 	flags = fcntl(fd, F_GETFL);
 	flags &= ~(FASYNC | NOBLOCK);
@@ -214,6 +393,7 @@ KdRegisterFd(int type, int fd, void (*read) (int fd, void *closure),
 {
 	if (kdNumInputFds == KD_MAX_INPUT_FDS)
 		return FALSE;
+	KdBlockSigio();
 	kdInputFds[kdNumInputFds].type = type;
 	kdInputFds[kdNumInputFds].fd = fd;
 	kdInputFds[kdNumInputFds].read = read;
@@ -223,6 +403,7 @@ KdRegisterFd(int type, int fd, void (*read) (int fd, void *closure),
 	++kdNumInputFds;
 	if (kdInputEnabled)
 		KdAddFd(fd);
+	KdUnblockSigio();
 	return TRUE;
 }
 
@@ -245,6 +426,7 @@ void KdUnregisterFds(int type, Bool do_close)
 {
 	int i, j;
 
+	KdBlockSigio();
 	for (i = 0; i < kdNumInputFds;) {
 		if (kdInputFds[i].type == type) {
 			if (kdInputEnabled)
@@ -257,6 +439,7 @@ void KdUnregisterFds(int type, Bool do_close)
 		} else
 			i++;
 	}
+	KdUnblockSigio();
 }
 
 void KdDisableInput(void)
@@ -568,6 +751,10 @@ void KdInitInput(const KdMouseFuncs * const pMouseFuncs,
 	kdLeds = 0;
 	kdBellPitch = 1000;
 	kdBellDuration = 200;
+#ifdef INPUT_THREAD
+	if (kdInputThread && !kdInputThreadRunning)
+		KdStartInputThread();
+#endif
 	kdInputEnabled = TRUE;
 	KdInitModMap();
 	KdInitAutoRepeats();
@@ -1485,7 +1672,9 @@ KdBlockHandler(int screen, pointer blockData, pointer timeout, pointer readmask)
 	}
 	/* if we need to poll for events, do that */
 	if (kdOsFuncs->pollEvents) {
+		KdBlockSigio();
 		(*kdOsFuncs->pollEvents) ();
+		KdUnblockSigio();
 		myTimeout = 20;
 	}
 	if (myTimeout > 0)
@@ -1511,6 +1700,11 @@ KdWakeupHandler(int screen,
 
 	KdMouseInfo *mi;
 
+#ifdef INPUT_THREAD
+	if (kdInputThreadRunning && result > 0 &&
+	    FD_ISSET(kdWakeFd[0], pReadmask))
+		KdDrainFd(kdWakeFd);
+#endif
 	if (kdInputEnabled && result > 0) {
 		for (i = 0; i < kdNumInputFds; i++) {
 			if (FD_ISSET(kdInputFds[i].fd, pReadmask)) {
@@ -1532,7 +1726,9 @@ KdWakeupHandler(int screen,
 	    (GetTimeInMillis() - last_time) >= 250 &&
 	    (GetTimeInMillis() - repeat_time) >= 1000 / keyboard_rate) {
 		repeat_time = GetTimeInMillis();
+		KdBlockSigio();
 		KdEnqueueKeyboardEvent(last_scancode, last_up);
+		KdUnblockSigio();
 		if (AutorepeatTimer) {
 			TimerFree(AutorepeatTimer);
 			AutorepeatTimer = NULL;
@@ -1663,7 +1859,9 @@ miPointerScreenFuncRec kdPointerScreenFuncs = {
 void ProcessInputEvents()
 {
 	mieqProcessInputEvents();
+	KdBlockSigio();
 	miPointerUpdate();
+	KdUnblockSigio();
 	if (kdSwitchPending)
 		KdProcessSwitch();
 	KdCheckLock();
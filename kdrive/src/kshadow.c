@@ -56,21 +56,40 @@ void KdShadowFbFree(KdScreenInfo * screen)
 	}
 }
 
-Bool
-KdShadowSet(ScreenPtr pScreen, int randr, ShadowUpdateProc update,
-	    ShadowWindowProc window)
+static Bool
+KdShadowSetup(ScreenPtr pScreen, int randr, ShadowUpdateProc update,
+	      ShadowWindowProc window, int nthreads)
 {
 	KdScreenPriv(pScreen);
 	KdScreenInfo *screen = pScreenPriv->screen;
 
 	shadowRemove(pScreen, pScreen->GetScreenPixmap(pScreen));
 	if (screen->fb.shadow) {
-		return shadowAdd(pScreen, pScreen->GetScreenPixmap(pScreen),
-				 update, window, randr, 0);
+		if (!shadowAdd(pScreen, pScreen->GetScreenPixmap(pScreen),
+			       update, window, randr, 0))
+			return FALSE;
+		shadowSetRate(pScreen, kdShadowRate);
+		if (!shadowSetThreads(pScreen, nthreads))
+			ErrorF("Failed to start shadow update threads\n");
 	}
 	return TRUE;
 }
 
+Bool
+KdShadowSet(ScreenPtr pScreen, int randr, ShadowUpdateProc update,
+	    ShadowWindowProc window)
+{
+	return KdShadowSetup(pScreen, randr, update, window, kdShadowThreads);
+}
+
+/* For update or window procs that must stay on the main thread */
+Bool
+KdShadowSetSerial(ScreenPtr pScreen, int randr, ShadowUpdateProc update,
+		  ShadowWindowProc window)
+{
+	return KdShadowSetup(pScreen, randr, update, window, 0);
+}
+
 void KdShadowUnset(ScreenPtr pScreen)
 {
 	shadowRemove(pScreen, pScreen->GetScreenPixmap(pScreen));
@@ -777,6 +777,9 @@ static Bool vesaSetShadow(ScreenPtr pScreen)
 		break;
 	}
 
+	/* Banked and planar windows touch the hardware, keep them serial */
+	if (window != vesaWindowLinear)
+		return KdShadowSetSerial(pScreen, pscr->randr, update, window);
 	return KdShadowSet(pScreen, pscr->randr, update, window);
 }
 
@@ -869,6 +872,10 @@ static Bool vesaComputeFramebufferMapping(KdScreenInfo * screen)
 	if (vesa_shadow)
 		pscr->shadow = vesa_shadow;
 
+	/* the cursor is only ever drawn into the frame buffer by the shadow */
+	if (screen->shadowCursor)
+		pscr->shadow = TRUE;
+
 	if (pscr->mapping == VESA_LINEAR
 	    && !(pscr->mode.ModeAttributes & MODE_LINEAR)) {
 		pscr->mapping = VESA_WINDOWED;
@@ -345,7 +345,7 @@ static Bool wsfbMapFramebuffer(KdScreenInfo * screen)
 	KdMouseMatrix m;
 	FbdevPriv *priv = screen->card->driver;
 
-	if (scrpriv->randr != RR_Rotate_0)
+	if (scrpriv->randr != RR_Rotate_0 || screen->shadowCursor)
 		scrpriv->shadow = TRUE;
 	else
 		scrpriv->shadow = FALSE;
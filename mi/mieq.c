@@ -30,6 +30,12 @@ in this Software without prior written authorization from The Open Group.
  *
  * Machine independent event queue
  *
+ * The queue is a ring with a single producer and a single consumer: the
+ * input code fills it, possibly from a signal handler or an input thread,
+ * and mieqProcessInputEvents empties it.  Each side only writes its own
+ * index, publishing it after the event it covers, so neither needs to
+ * lock the other out.  Anything enqueueing from more than one place must
+ * be serialized by the caller, as the ddx does by blocking its input.
  */
 
 #if HAVE_DIX_CONFIG_H
@@ -46,7 +52,11 @@ in this Software without prior written authorization from The Open Group.
 # include   "mi.h"
 # include   "scrnintstr.h"
 
-#define QUEUE_SIZE  256
+#define QUEUE_SIZE  512	/* a power of two */
+#define QUEUE_MASK  (QUEUE_SIZE - 1)
+
+#define QueueLoad(i)	    __atomic_load_n(&(i), __ATOMIC_ACQUIRE)
+#define QueueStore(i,v)	    __atomic_store_n(&(i), (v), __ATOMIC_RELEASE)
 
 typedef struct _Event {
     xEvent	event;
@@ -56,7 +66,6 @@ typedef struct _Event {
 typedef struct _EventQueue {
     HWEventQueueType	head, tail;	    /* long for SetInputCheck */
     CARD32	lastEventTime;	    /* to avoid time running backwards */
-    Bool	lastMotion;
     EventRec	events[QUEUE_SIZE]; /* static allocation for signals */
     DevicePtr	pKbd, pPtr;	    /* device pointer, to get funcs */
     ScreenPtr	pEnqueueScreen;	    /* screen events are being delivered to */
@@ -73,7 +82,6 @@ mieqInit (pKbd, pPtr)
     miEventQueue.lastEventTime = GetTimeInMillis ();
     miEventQueue.pKbd = pKbd;
     miEventQueue.pPtr = pPtr;
-    miEventQueue.lastMotion = FALSE;
     miEventQueue.pEnqueueScreen = screenInfo.screens[0];
     miEventQueue.pDequeueScreen = miEventQueue.pEnqueueScreen;
     SetInputCheck (&miEventQueue.head, &miEventQueue.tail);
@@ -84,7 +92,9 @@ mieqInit (pKbd, pPtr)
  * Must be reentrant with ProcessInputEvents.  Assumption: mieqEnqueue
  * will never be interrupted.  If this is called from both signal
  * handlers and regular code, make sure the signal is suspended when
- * called from regular code.
+ * called from regular code.  Runs of motion are collapsed as they are
+ * taken off the queue, since the slot last filled may already be in
+ * the consumer's hands.
  */
 
 void
@@ -92,27 +102,12 @@ mieqEnqueue (e)
     xEvent	*e;
 {
     HWEventQueueType	oldtail, newtail;
-    Bool    isMotion;
 
     oldtail = miEventQueue.tail;
-    isMotion = e->u.u.type == MotionNotify;
-    if (isMotion && miEventQueue.lastMotion && oldtail != miEventQueue.head)
-    {
-	if (oldtail == 0)
-	    oldtail = QUEUE_SIZE;
-	oldtail = oldtail - 1;
-    }
-    else
-    {
-    	newtail = oldtail + 1;
-    	if (newtail == QUEUE_SIZE)
-	    newtail = 0;
-    	/* Toss events which come in late */
-    	if (newtail == miEventQueue.head)
-	    return;
-	miEventQueue.tail = newtail;
-    }
-    miEventQueue.lastMotion = isMotion;
+    newtail = (oldtail + 1) & QUEUE_MASK;
+    /* Toss events which come in late */
+    if (newtail == QueueLoad(miEventQueue.head))
+	return;
     miEventQueue.events[oldtail].event = *e;
     /*
      * Make sure that event times don't go backwards - this
@@ -127,6 +122,7 @@ mieqEnqueue (e)
     miEventQueue.lastEventTime =
 	miEventQueue.events[oldtail].event.u.keyButtonPointer.time;
     miEventQueue.events[oldtail].pScreen = miEventQueue.pEnqueueScreen;
+    QueueStore(miEventQueue.tail, newtail);
 }
 
 void
@@ -146,36 +142,39 @@ mieqSwitchScreen (pScreen, fromDIX)
 void mieqProcessInputEvents ()
 {
     EventRec	*e;
-    int		x, y;
+    HWEventQueueType	head, next, tail;
+    ScreenPtr	pScreen;
     xEvent	xe;
 
-    while (miEventQueue.head != miEventQueue.tail)
+    head = miEventQueue.head;
+    while (head != (tail = QueueLoad(miEventQueue.tail)))
     {
 	if (screenIsSaved == SCREEN_SAVER_ON)
 	    SaveScreens (SCREEN_SAVER_OFF, ScreenSaverReset);
 
-	e = &miEventQueue.events[miEventQueue.head];
+	e = &miEventQueue.events[head];
+	next = (head + 1) & QUEUE_MASK;
+	/* only the last of consecutive motion events matters */
+	if (e->event.u.u.type == MotionNotify && next != tail &&
+	    miEventQueue.events[next].event.u.u.type == MotionNotify)
+	{
+	    QueueStore(miEventQueue.head, head = next);
+	    continue;
+	}
+	xe = e->event;
+	pScreen = e->pScreen;
+	QueueStore(miEventQueue.head, head = next);
 	/*
 	 * Assumption - screen switching can only occur on motion events
 	 */
-	if (e->pScreen != miEventQueue.pDequeueScreen)
+	if (pScreen != miEventQueue.pDequeueScreen)
 	{
-	    miEventQueue.pDequeueScreen = e->pScreen;
-	    x = e->event.u.keyButtonPointer.rootX;
-	    y = e->event.u.keyButtonPointer.rootY;
-	    if (miEventQueue.head == QUEUE_SIZE - 1)
-	    	miEventQueue.head = 0;
-	    else
-	    	++miEventQueue.head;
-	    NewCurrentScreen (miEventQueue.pDequeueScreen, x, y);
+	    miEventQueue.pDequeueScreen = pScreen;
+	    NewCurrentScreen (pScreen, xe.u.keyButtonPointer.rootX,
+			      xe.u.keyButtonPointer.rootY);
 	}
 	else
 	{
-	    xe = e->event;
-	    if (miEventQueue.head == QUEUE_SIZE - 1)
-	    	miEventQueue.head = 0;
-	    else
-	    	++miEventQueue.head;
 	    switch (xe.u.u.type)
 	    {
 	    case KeyPress:
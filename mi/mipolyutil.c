@@ -104,7 +104,7 @@ miInsertEdgeInET(ET, ETE, scanline, SLLBlock, iSLLBlock)
         if (*iSLLBlock > SLLSPERBLOCK-1)
         {
             tmpSLLBlock =
-		  (ScanLineListBlock *)malloc(sizeof(ScanLineListBlock));
+		  (ScanLineListBlock *)ScratchAlloc(sizeof(ScanLineListBlock));
 	    if (!tmpSLLBlock)
 		return FALSE;
             (*SLLBlock)->next = tmpSLLBlock;
@@ -393,7 +393,7 @@ miFreeStorage(pSLLBlock)
     while (pSLLBlock)
     {
         tmpSLLBlock = pSLLBlock->next;
-        free(pSLLBlock);
+        ScratchFree(pSLLBlock);
         pSLLBlock = tmpSLLBlock;
     }
 }
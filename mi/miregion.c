@@ -85,6 +85,10 @@ Equipment Corporation.
 #include "mi.h"
 #include "mispans.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #if defined (__GNUC__) && !defined (NO_INLINES)
 #define INLINE	__inline
 #else
@@ -479,14 +483,30 @@ miCoalesce (
      */
     y2 = pCurBox->y2;
 
-    do {
+#ifdef __SSE2__
+    /*
+     * Two boxes at a time: compare all eight shorts and only look at
+     * the x1 and x2 lanes.
+     */
+    while (numRects >= 2) {
+	__m128i prev = _mm_loadu_si128((__m128i *) pPrevBox);
+	__m128i cur = _mm_loadu_si128((__m128i *) pCurBox);
+
+	if ((_mm_movemask_epi8(_mm_cmpeq_epi16(prev, cur)) & 0x3333) != 0x3333)
+	    return (curStart);
+	pPrevBox += 2;
+	pCurBox += 2;
+	numRects -= 2;
+    }
+#endif
+    while (numRects) {
 	if ((pPrevBox->x1 != pCurBox->x1) || (pPrevBox->x2 != pCurBox->x2)) {
 	    return (curStart);
 	}
 	pPrevBox++;
 	pCurBox++;
 	numRects--;
-    } while (numRects);
+    }
 
     /*
      * The bands may be merged, so set the bottom y of each box
@@ -578,6 +598,41 @@ miAppendNonO (
     }									\
 }
 
+/*
+ * Find the first box in r..rEnd reaching below y.  The y2 of the boxes
+ * of a region never decreases, so this is a binary search, and since all
+ * boxes in a band share y2 the answer always starts a band.
+ */
+static BoxPtr
+miFindBandBelow (
+    BoxPtr	r,
+    BoxPtr	rEnd,
+    int		y)
+{
+    int		n = rEnd - r;
+
+    while (n > 0)
+    {
+	int half = n >> 1;
+
+	if (r[half].y2 <= y)
+	{
+	    r += half + 1;
+	    n -= half + 1;
+	}
+	else
+	    n = half;
+    }
+    return r;
+}
+
+/*
+ * Results no larger than this are built in a buffer on the stack and
+ * copied out once, so that those coming to one rectangle or none never
+ * allocate and the rest allocate exactly once, if at all.
+ */
+#define MI_REGION_OP_INLINE	128
+
 /*-
  *-----------------------------------------------------------------------
  * miRegionOp --
@@ -619,7 +674,7 @@ typedef Bool (*OverlapProcPtr)(
 
 static Bool
 miRegionOp(
-    RegionPtr       newReg,		    /* Place to store result	     */
+    RegionPtr       dstReg,		    /* Place to store result	     */
     RegionPtr       reg1,		    /* First region in operation     */
     RegionPtr       reg2,		    /* 2d region in operation        */
     OverlapProcPtr  overlapFunc,            /* Function to call for over-
@@ -649,12 +704,18 @@ miRegionOp(
     int    r2y1;
     int		    newSize;
     int		    numRects;
+    RegionPtr	    newReg;		    /* Region being built	     */
+    RegionRec	    inlineReg;
+    struct {
+	RegDataRec  data;
+	BoxRec	    boxes[MI_REGION_OP_INLINE];
+    }		    inlineData;
 
     /*
      * Break any region computed from a broken region
      */
     if (REGION_NAR (reg1) || REGION_NAR(reg2))
-	return miRegionBreak (newReg);
+	return miRegionBreak (dstReg);
 
     /*
      * Initialization:
@@ -674,23 +735,41 @@ miRegionOp(
     assert(r2 != r2End);
 
     oldData = (RegDataPtr)NULL;
-    if (((newReg == reg1) && (newSize > 1)) ||
-	((newReg == reg2) && (numRects > 1)))
+    if (newSize <= MI_REGION_OP_INLINE && numRects <= MI_REGION_OP_INLINE &&
+	newSize + numRects + 4 * newSize * numRects <= MI_REGION_OP_INLINE)
     {
-	oldData = newReg->data;
-	newReg->data = &miEmptyData;
-    }
-    /* guess at new size */
-    if (numRects > newSize)
-	newSize = numRects;
-    newSize <<= 1;
-    if (!newReg->data)
-	newReg->data = &miEmptyData;
-    else if (newReg->data->size)
+	/*
+	 * Each band of one region is cut into at most 2n + 1 bands by the
+	 * other, n rectangles having at most 2n distinct edges, and every
+	 * operator leaves no more rectangles in a band than the two regions
+	 * had in it; so the result can't outgrow the inline buffer.
+	 */
+	newReg = &inlineReg;
+	newReg->data = &inlineData.data;
+	newReg->data->size = MI_REGION_OP_INLINE;
 	newReg->data->numRects = 0;
-    if (newSize > newReg->data->size)
-	if (!miRectAlloc(newReg, newSize))
-	    return FALSE;
+    }
+    else
+    {
+	newReg = dstReg;
+	if (((newReg == reg1) && (newSize > 1)) ||
+	    ((newReg == reg2) && (numRects > 1)))
+	{
+	    oldData = newReg->data;
+	    newReg->data = &miEmptyData;
+	}
+	/* guess at new size */
+	if (numRects > newSize)
+	    newSize = numRects;
+	newSize <<= 1;
+	if (!newReg->data)
+	    newReg->data = &miEmptyData;
+	else if (newReg->data->size)
+	    newReg->data->numRects = 0;
+	if (newSize > newReg->data->size)
+	    if (!miRectAlloc(newReg, newSize))
+		return FALSE;
+    }
 
     /*
      * Initialize ybot.
@@ -719,7 +798,43 @@ miRegionOp(
      */
     prevBand = 0;
 
-    do {
+    /*
+     * Bands of one region lying wholly above the other region need no
+     * operator at all: find the first band reaching down into the other
+     * region and either append everything before it in one go or skip
+     * it.  This makes a rectangle against a large region cost little
+     * more than the part of the region the rectangle spans.
+     */
+    if (r1->y2 <= r2->y1)
+    {
+	r1BandEnd = miFindBandBelow(r1, r1End, r2->y1);
+	if (appendNon1)
+	{
+	    BoxPtr last = r1BandEnd - 1;
+
+	    while (last != r1 && last[-1].y1 == last->y1)
+		last--;
+	    prevBand = newReg->data->numRects + (last - r1);
+	    AppendRegions(newReg, r1, r1BandEnd);
+	}
+	r1 = r1BandEnd;
+    }
+    else if (r2->y2 <= r1->y1)
+    {
+	r2BandEnd = miFindBandBelow(r2, r2End, r1->y1);
+	if (appendNon2)
+	{
+	    BoxPtr last = r2BandEnd - 1;
+
+	    while (last != r2 && last[-1].y1 == last->y1)
+		last--;
+	    prevBand = newReg->data->numRects + (last - r2);
+	    AppendRegions(newReg, r2, r2BandEnd);
+	}
+	r2 = r2BandEnd;
+    }
+
+    while (r1 != r1End && r2 != r2End) {
 	/*
 	 * This algorithm proceeds one source-band (as opposed to a
 	 * destination band, which is determined by where the two regions
@@ -786,7 +901,7 @@ miRegionOp(
 	if (r1->y2 == ybot) r1 = r1BandEnd;
 	if (r2->y2 == ybot) r2 = r2BandEnd;
 
-    } while (r1 != r1End && r2 != r2End);
+    }
 
     /*
      * Deal with whichever region (if any) still has rectangles left.
@@ -818,6 +933,37 @@ miRegionOp(
     if (oldData)
 	free(oldData);
 
+    if (newReg == &inlineReg)
+    {
+	numRects = newReg->data->numRects;
+	if (numRects <= 1)
+	{
+	    xfreeData(dstReg);
+	    if (numRects)
+	    {
+		dstReg->extents = inlineData.boxes[0];
+		dstReg->data = (RegDataPtr)NULL;
+	    }
+	    else
+		dstReg->data = &miEmptyData;
+	    return TRUE;
+	}
+	/* copy out, reusing the destination's rectangles if they'll do */
+	if (!dstReg->data || dstReg->data->size < numRects)
+	{
+	    xfreeData(dstReg);
+	    dstReg->data = xallocData(numRects);
+	    if (!dstReg->data)
+		return miRegionBreak (dstReg);
+	    dstReg->data->size = numRects;
+	}
+	dstReg->data->numRects = numRects;
+	memmove((char *)REGION_BOXPTR(dstReg), (char *)inlineData.boxes,
+		numRects * sizeof(BoxRec));
+	DOWNSIZE(dstReg, numRects);
+	return TRUE;
+    }
+
     if (!(numRects = newReg->data->numRects))
     {
 	xfreeData(newReg);
@@ -1180,6 +1326,32 @@ miUnion(newReg, reg1, reg2)
         return TRUE;
     }
 
+    /*
+     * Two rectangles sharing both sides in one direction and touching or
+     * overlapping in the other make a single rectangle
+     */
+    if (!reg1->data && !reg2->data &&
+	(((reg1->extents.x1 == reg2->extents.x1) &&
+	  (reg1->extents.x2 == reg2->extents.x2) &&
+	  (reg1->extents.y1 <= reg2->extents.y2) &&
+	  (reg2->extents.y1 <= reg1->extents.y2)) ||
+	 ((reg1->extents.y1 == reg2->extents.y1) &&
+	  (reg1->extents.y2 == reg2->extents.y2) &&
+	  (reg1->extents.x1 <= reg2->extents.x2) &&
+	  (reg2->extents.x1 <= reg1->extents.x2))))
+    {
+	BoxRec	box;
+
+	box.x1 = min(reg1->extents.x1, reg2->extents.x1);
+	box.y1 = min(reg1->extents.y1, reg2->extents.y1);
+	box.x2 = max(reg1->extents.x2, reg2->extents.x2);
+	box.y2 = max(reg1->extents.y2, reg2->extents.y2);
+	xfreeData(newReg);
+	newReg->extents = box;
+	newReg->data = (RegDataPtr)NULL;
+	return TRUE;
+    }
+
     if (!miRegionOp(newReg, reg1, reg2, miUnionO, TRUE, TRUE, &overlap))
 	return FALSE;
 
@@ -153,12 +153,12 @@ void miSubtractSpans (spanGroup, sub)
 				int	    *newwid;
 
 #define EXTRA 8
-				newPt = (DDXPointPtr) realloc(spans->points, (spans->count + EXTRA) * sizeof (DDXPointRec));
+				newPt = (DDXPointPtr) ScratchRealloc(spans->points, (spans->count + EXTRA) * sizeof (DDXPointRec));
 				if (!newPt)
 				    break;
 				spansPt = newPt + (spansPt - spans->points);
 				spans->points = newPt;
-				newwid = (int *) realloc(spans->widths, (spans->count + EXTRA) * sizeof (int));
+				newwid = (int *) ScratchRealloc(spans->widths, (spans->count + EXTRA) * sizeof (int));
 				if (!newwid)
 				    break;
 				spansWid = newwid + (spansWid - spans->widths);
@@ -196,7 +196,7 @@ void miAppendSpans(spanGroup, otherGroup, spans)
 	if (spanGroup->size == spanGroup->count) {
 	    spanGroup->size = (spanGroup->size + 8) * 2;
 	    spanGroup->group = (Spans *)
-		realloc(spanGroup->group, sizeof(Spans) * spanGroup->size);
+		ScratchRealloc(spanGroup->group, sizeof(Spans) * spanGroup->size);
 	 }
 
 	spanGroup->group[spanGroup->count] = *spans;
@@ -214,15 +214,15 @@ void miAppendSpans(spanGroup, otherGroup, spans)
     }
     else
     {
-	free(spans->points);
-	free(spans->widths);
+	ScratchFree(spans->points);
+	ScratchFree(spans->widths);
     }
 } /* AppendSpans */
 
 void miFreeSpanGroup(spanGroup)
     SpanGroup   *spanGroup;
 {
-    if (spanGroup->group != NULL) free(spanGroup->group);
+    if (spanGroup->group != NULL) ScratchFree(spanGroup->group);
 }
 
 static void QuickSortSpansX(
@@ -374,8 +374,8 @@ miDisposeSpanGroup (spanGroup)
     for (i = 0; i < spanGroup->count; i++)
     {
 	spans = spanGroup->group + i;
-	free(spans->points);
-	free(spans->widths);
+	ScratchFree(spans->points);
+	ScratchFree(spans->widths);
     }
 }
 
@@ -402,8 +402,8 @@ void miFillUniqueSpanGroup(pDraw, pGC, spanGroup)
 	spans = spanGroup->group;
 	(*pGC->ops->FillSpans)
 	    (pDraw, pGC, spans->count, spans->points, spans->widths, TRUE);
-	free(spans->points);
-	free(spans->widths);
+	ScratchFree(spans->points);
+	ScratchFree(spans->widths);
     }
     else
     {
@@ -416,15 +416,15 @@ void miFillUniqueSpanGroup(pDraw, pGC, spanGroup)
 	ylength = spanGroup->ymax - ymin + 1;
 
 	/* Allocate Spans for y buckets */
-	yspans = malloc(ylength * sizeof(Spans));
-	ysizes = malloc(ylength * sizeof (int));
+	yspans = ScratchAlloc(ylength * sizeof(Spans));
+	ysizes = ScratchAlloc(ylength * sizeof (int));
 
 	if (!yspans || !ysizes)
 	{
 	    if (yspans)
-		free(yspans);
+		ScratchFree(yspans);
 	    if (ysizes)
-		free(ysizes);
+		ScratchFree(ysizes);
 	    miDisposeSpanGroup (spanGroup);
 	    return;
 	}
@@ -454,10 +454,10 @@ void miFillUniqueSpanGroup(pDraw, pGC, spanGroup)
 			DDXPointPtr newpoints;
 			int	    *newwidths;
 			ysizes[index] = (ysizes[index] + 8) * 2;
-			newpoints = (DDXPointPtr) realloc(
+			newpoints = (DDXPointPtr) ScratchRealloc(
 			    newspans->points,
 			    ysizes[index] * sizeof(DDXPointRec));
-			newwidths = (int *) realloc(
+			newwidths = (int *) ScratchRealloc(
 			    newspans->widths,
 			    ysizes[index] * sizeof(int));
 			if (!newpoints || !newwidths)
@@ -466,13 +466,13 @@ void miFillUniqueSpanGroup(pDraw, pGC, spanGroup)
 
 			    for (i = 0; i < ylength; i++)
 			    {
-				free(yspans[i].points);
-				free(yspans[i].widths);
+				ScratchFree(yspans[i].points);
+				ScratchFree(yspans[i].widths);
 			    }
-			    free(yspans);
-			    free(ysizes);
-			    free(newpoints);
-			    free(newwidths);
+			    ScratchFree(yspans);
+			    ScratchFree(ysizes);
+			    ScratchFree(newpoints);
+			    ScratchFree(newwidths);
 			    miDisposeSpanGroup (spanGroup);
 			    return;
 			}
@@ -485,30 +485,30 @@ void miFillUniqueSpanGroup(pDraw, pGC, spanGroup)
 		} /* if y value of span in range */
 	    } /* for j through spans */
 	    count += spans->count;
-	    free(spans->points);
+	    ScratchFree(spans->points);
 	    spans->points = NULL;
-	    free(spans->widths);
+	    ScratchFree(spans->widths);
 	    spans->widths = NULL;
 	} /* for i thorough Spans */
 
 	/* Now sort by x and uniquify each bucket into the final array */
-	points = malloc(count * sizeof(DDXPointRec));
-	widths = (int *)       malloc(count * sizeof(int));
+	points = ScratchAlloc(count * sizeof(DDXPointRec));
+	widths = (int *)       ScratchAlloc(count * sizeof(int));
 	if (!points || !widths)
 	{
 	    int	i;
 
 	    for (i = 0; i < ylength; i++)
 	    {
-		free(yspans[i].points);
-		free(yspans[i].widths);
+		ScratchFree(yspans[i].points);
+		ScratchFree(yspans[i].widths);
 	    }
-	    free(yspans);
-	    free(ysizes);
+	    ScratchFree(yspans);
+	    ScratchFree(ysizes);
 	    if (points)
-		free(points);
+		ScratchFree(points);
 	    if (widths)
-		free(widths);
+		ScratchFree(widths);
 	    return;
 	}
 	count = 0;
@@ -524,16 +524,16 @@ void miFillUniqueSpanGroup(pDraw, pGC, spanGroup)
 		    widths[count] = yspans[i].widths[0];
 		    count++;
 		}
-		free(yspans[i].points);
-		free(yspans[i].widths);
+		ScratchFree(yspans[i].points);
+		ScratchFree(yspans[i].widths);
 	    }
 	}
 
 	(*pGC->ops->FillSpans) (pDraw, pGC, count, points, widths, TRUE);
-	free(points);
-	free(widths);
-	free(yspans);
-	free(ysizes);		/* use (DE)ALLOCATE_LOCAL for these? */
+	ScratchFree(points);
+	ScratchFree(widths);
+	ScratchFree(yspans);
+	ScratchFree(ysizes);		/* use (DE)ALLOCATE_LOCAL for these? */
     }
 
     spanGroup->count = 0;
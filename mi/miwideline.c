@@ -126,13 +126,13 @@ miFillPolyHelper (pDrawable, pGC, pixel, spanData, y, overall_height,
     }
     else
     {
-	spanRec.points = malloc(overall_height * sizeof (*ppt));
+	spanRec.points = ScratchAlloc(overall_height * sizeof (*ppt));
 	if (!spanRec.points)
 	    return;
-	spanRec.widths = malloc(overall_height * sizeof (int));
+	spanRec.widths = ScratchAlloc(overall_height * sizeof (int));
 	if (!spanRec.widths)
 	{
-	    free(spanRec.points);
+	    ScratchFree(spanRec.points);
 	    return;
 	}
 	ppt = spanRec.points;
@@ -231,13 +231,13 @@ miFillRectPolyHelper (
     }
     else
     {
-	spanRec.points = malloc(h * sizeof (*ppt));
+	spanRec.points = ScratchAlloc(h * sizeof (*ppt));
 	if (!spanRec.points)
 	    return;
-	spanRec.widths = malloc(h * sizeof (int));
+	spanRec.widths = ScratchAlloc(h * sizeof (int));
 	if (!spanRec.widths)
 	{
-	    free(spanRec.points);
+	    ScratchFree(spanRec.points);
 	    return;
 	}
 	ppt = spanRec.points;
@@ -1077,13 +1077,13 @@ miLineArc (
     }
     else
     {
-	points = malloc(pGC->lineWidth * sizeof (DDXPointRec));
+	points = ScratchAlloc(pGC->lineWidth * sizeof (DDXPointRec));
 	if (!points)
 	    return;
-	widths = malloc(pGC->lineWidth * sizeof (int));
+	widths = ScratchAlloc(pGC->lineWidth * sizeof (int));
 	if (!widths)
 	{
-	    free(points);
+	    ScratchFree(points);
 	    return;
 	}
 	spanRec.points = points;
@@ -60,17 +60,73 @@ shadowRedisplay(ScreenPtr pScreen)
         return;
     pRegion = DamageRegion(pBuf->pDamage);
     if (REGION_NOTEMPTY(pRegion)) {
-        (*pBuf->update) (pScreen, pBuf);
+        Bool cursor;
+
+        if (pBuf->prepare)
+            (*pBuf->prepare) (pScreen, pBuf);
+        shadowTileDamage(pBuf, pRegion);
+        cursor = shadowCursorPaint(pScreen, pBuf, pRegion);
+        if (pBuf->threads)
+            shadowThreadsUpdate(pScreen, pBuf);
+        else
+            (*pBuf->update) (pScreen, pBuf);
+        /* the workers have to be done with the cursor before it goes */
+        if (cursor) {
+            shadowSync(pScreen);
+            shadowCursorRestore(pScreen, pBuf);
+        }
         DamageEmpty(pBuf->pDamage);
+        pBuf->lastFlush = GetTimeInMillis();
     }
 }
 
+static CARD32
+shadowTimerExpire(OsTimerPtr pTimer, CARD32 now, pointer arg)
+{
+    ScreenPtr pScreen = (ScreenPtr) arg;
+
+    shadowBuf(pScreen);
+
+    pBuf->timerPending = FALSE;
+    shadowRedisplay(pScreen);
+    return 0;
+}
+
+/*
+ * With a refresh cap set, damage piling up between frames is left alone
+ * until the frame interval has passed; a timer makes sure the last
+ * frame of a burst still goes out when the clients go quiet.
+ */
 static void
 shadowBlockHandler(pointer data, OSTimePtr pTimeout, pointer pRead)
 {
     ScreenPtr pScreen = (ScreenPtr) data;
 
-    shadowRedisplay(pScreen);
+    shadowBuf(pScreen);
+    CARD32 now, elapsed;
+
+    if (!pBuf->interval) {
+        shadowRedisplay(pScreen);
+        return;
+    }
+    if (pBuf->timerPending || !pBuf->pDamage ||
+        !REGION_NOTEMPTY(DamageRegion(pBuf->pDamage)))
+        return;
+    now = GetTimeInMillis();
+    elapsed = now - pBuf->lastFlush;
+    if (elapsed >= pBuf->interval) {
+        shadowRedisplay(pScreen);
+        return;
+    }
+    pBuf->pTimer = TimerSet(pBuf->pTimer, TimerAbsolute,
+                            pBuf->lastFlush + pBuf->interval,
+                            shadowTimerExpire, pScreen);
+    if (pBuf->pTimer) {
+        pBuf->timerPending = TRUE;
+        AdjustWaitForDelay(pTimeout, pBuf->interval - elapsed);
+    }
+    else
+        shadowRedisplay(pScreen);
 }
 
 static void
@@ -87,8 +143,10 @@ shadowGetImage(DrawablePtr pDrawable, int sx, int sy, int w, int h,
     shadowBuf(pScreen);
 
     /* Many apps use GetImage to sync with the visable frame buffer */
-    if (pDrawable->type == DRAWABLE_WINDOW)
+    if (pDrawable->type == DRAWABLE_WINDOW) {
         shadowRedisplay(pScreen);
+        shadowSync(pScreen);
+    }
     unwrap(pBuf, pScreen, GetImage);
     pScreen->GetImage(pDrawable, sx, sy, w, h, format, planeMask, pdstLine);
     wrap(pBuf, pScreen, GetImage);
@@ -104,6 +162,8 @@ shadowCloseScreen(int i, ScreenPtr pScreen)
     unwrap(pBuf, pScreen, GetImage);
     unwrap(pBuf, pScreen, CloseScreen);
     shadowRemove(pScreen, pBuf->pPixmap);
+    TimerFree(pBuf->pTimer);
+    shadowCursorDestroy(pBuf);
     DamageDestroy(pBuf->pDamage);
 #ifdef BACKWARDS_COMPATIBILITY
     REGION_UNINIT(&pBuf->damage);      /* bc */
@@ -142,6 +202,8 @@ shadowSetup(ScreenPtr pScreen)
     if (!DamageSetup(pScreen))
         return FALSE;
 
+    shadowCopyInit();
+
     if (shadowGeneration != serverGeneration) {
         shadowScrPrivateIndex = AllocateScreenPrivateIndex();
         if (shadowScrPrivateIndex == -1)
@@ -173,6 +235,14 @@ shadowSetup(ScreenPtr pScreen)
     pBuf->pPixmap = 0;
     pBuf->closure = 0;
     pBuf->randr = 0;
+    pBuf->threads = 0;
+    pBuf->tiles = 0;
+    pBuf->cursor = 0;
+    pBuf->prepare = 0;
+    pBuf->interval = 0;
+    pBuf->lastFlush = 0;
+    pBuf->pTimer = 0;
+    pBuf->timerPending = FALSE;
 #ifdef BACKWARDS_COMPATIBILITY
     REGION_NULL(&pBuf->damage);        /* bc */
 #endif
@@ -223,9 +293,14 @@ shadowRemove(ScreenPtr pScreen, PixmapPtr pPixmap)
 {
     shadowBuf(pScreen);
 
+    shadowSetThreads(pScreen, 0);
+    shadowTilesDestroy(pBuf);
+    TimerCancel(pBuf->pTimer);
+    pBuf->timerPending = FALSE;
     if (pBuf->pPixmap) {
         DamageUnregister(&pBuf->pPixmap->drawable, pBuf->pDamage);
         pBuf->update = 0;
+        pBuf->prepare = 0;
         pBuf->window = 0;
         pBuf->randr = 0;
         pBuf->closure = 0;
@@ -236,6 +311,26 @@ shadowRemove(ScreenPtr pScreen, PixmapPtr pPixmap)
                                  (pointer) pScreen);
 }
 
+void
+shadowSetRate(ScreenPtr pScreen, int hz)
+{
+    shadowBuf(pScreen);
+
+    pBuf->interval = hz > 0 ? (1000 + hz - 1) / hz : 0;
+}
+
+/*
+ * Have prepare called at each flush before anything else looks at the
+ * damage, for update procs that copy more than was damaged.
+ */
+void
+shadowSetPrepare(ScreenPtr pScreen, ShadowUpdateProc prepare)
+{
+    shadowBuf(pScreen);
+
+    pBuf->prepare = prepare;
+}
+
 Bool
 shadowInit(ScreenPtr pScreen, ShadowUpdateProc update, ShadowWindowProc window)
 {
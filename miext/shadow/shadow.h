@@ -30,6 +30,7 @@
 
 #include "damage.h"
 #include "damagestr.h"
+#include "mipointer.h"
 typedef struct _shadowBuf *shadowBufPtr;
 
 typedef void (*ShadowUpdateProc) (ScreenPtr pScreen, shadowBufPtr pBuf);
@@ -56,6 +57,25 @@ typedef struct _shadowBuf {
     /* screen wrappers */
     GetImageProcPtr GetImage;
     CloseScreenProcPtr CloseScreen;
+
+    /* flush workers, see shthread.c */
+    void *threads;
+
+    /* damage coalescing bitmap, see shtile.c */
+    void *tiles;
+
+    /* cursor plane, see shcursor.c */
+    void *cursor;
+
+    /* adds whatever else update will copy to the damage, before the
+       cursor is painted in */
+    ShadowUpdateProc prepare;
+
+    /* frame pacing; interval is 0 when every block flushes */
+    CARD32 interval;
+    CARD32 lastFlush;
+    OsTimerPtr pTimer;
+    Bool timerPending;
 } shadowBufRec;
 
 /* Match defines from randr extension */
@@ -96,6 +116,46 @@ shadowInit(ScreenPtr pScreen, ShadowUpdateProc update, ShadowWindowProc window);
 
 void *shadowAlloc(int width, int height, int bpp);
 
+void
+ shadowSetRate(ScreenPtr pScreen, int hz);
+
+void
+ shadowSetPrepare(ScreenPtr pScreen, ShadowUpdateProc prepare);
+
+Bool
+ shadowSetThreads(ScreenPtr pScreen, int nthreads);
+
+void
+ shadowSync(ScreenPtr pScreen);
+
+void
+ shadowThreadsUpdate(ScreenPtr pScreen, shadowBufPtr pBuf);
+
+void
+ shadowTileDamage(shadowBufPtr pBuf, RegionPtr pRegion);
+
+void
+ shadowTilesDestroy(shadowBufPtr pBuf);
+
+Bool
+ shadowCursorInit(ScreenPtr pScreen, miPointerScreenFuncPtr screenFuncs);
+
+Bool
+ shadowCursorPaint(ScreenPtr pScreen, shadowBufPtr pBuf, RegionPtr pRegion);
+
+void
+ shadowCursorRestore(ScreenPtr pScreen, shadowBufPtr pBuf);
+
+void
+ shadowCursorDestroy(shadowBufPtr pBuf);
+
+typedef void (*ShadowCopyProc) (void *dst, const void *src, CARD32 size);
+
+extern ShadowCopyProc shadowCopyLine;
+
+void
+ shadowCopyInit(void);
+
 void
  shadowUpdatePacked(ScreenPtr pScreen, shadowBufPtr pBuf);
 
@@ -0,0 +1,219 @@
+/*
+ *
+ * Copyright © 2026 Ace Husky <acehusky12@gmail.com>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of Ace Husky not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  Ace Husky makes no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * ACE HUSKY DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL ACE HUSKY BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Row copy used to push shadow scanlines out to the frame buffer.
+ *
+ * Frame buffer memory is normally mapped write-combined and never read
+ * back by the server, so the vector paths use streaming stores to keep
+ * the copy from evicting the shadow out of the cache.  Every copy is
+ * fenced before returning; windowed (banked) modes may move the
+ * aperture as soon as we hand control back to the update loop.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdint.h>
+
+#include    <X11/X.h>
+#include    "scrnintstr.h"
+#include    "shadow.h"
+
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SHADOW_COPY_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SHADOW_COPY_NEON
+#include <arm_neon.h>
+#endif
+
+/* Rows shorter than this are not worth the alignment prologue */
+#define SHADOW_COPY_MIN	256
+
+static void
+shadowCopyC(void *dst, const void *src, CARD32 size)
+{
+    CARD32 *d = dst;
+
+    const CARD32 *s = src;
+
+    size >>= 2;
+    while (size--)
+        *d++ = *s++;
+}
+
+#ifdef SHADOW_COPY_X86
+__attribute__ ((target("sse2")))
+static void
+shadowCopySSE2(void *dst, const void *src, CARD32 size)
+{
+    CARD8 *d = dst;
+
+    const CARD8 *s = src;
+
+    if (size < SHADOW_COPY_MIN) {
+        shadowCopyC(dst, src, size);
+        return;
+    }
+    while ((uintptr_t) d & 15) {
+        *(CARD32 *) d = *(const CARD32 *) s;
+        d += 4;
+        s += 4;
+        size -= 4;
+    }
+    while (size >= 64) {
+        __m128i a = _mm_loadu_si128((const __m128i *) (s + 0));
+        __m128i b = _mm_loadu_si128((const __m128i *) (s + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *) (s + 32));
+        __m128i e = _mm_loadu_si128((const __m128i *) (s + 48));
+
+        _mm_stream_si128((__m128i *) (d + 0), a);
+        _mm_stream_si128((__m128i *) (d + 16), b);
+        _mm_stream_si128((__m128i *) (d + 32), c);
+        _mm_stream_si128((__m128i *) (d + 48), e);
+        d += 64;
+        s += 64;
+        size -= 64;
+    }
+    while (size >= 16) {
+        _mm_stream_si128((__m128i *) d,
+                         _mm_loadu_si128((const __m128i *) s));
+        d += 16;
+        s += 16;
+        size -= 16;
+    }
+    _mm_sfence();
+    shadowCopyC(d, s, size);
+}
+
+__attribute__ ((target("avx2")))
+static void
+shadowCopyAVX2(void *dst, const void *src, CARD32 size)
+{
+    CARD8 *d = dst;
+
+    const CARD8 *s = src;
+
+    if (size < SHADOW_COPY_MIN) {
+        shadowCopyC(dst, src, size);
+        return;
+    }
+    while ((uintptr_t) d & 31) {
+        *(CARD32 *) d = *(const CARD32 *) s;
+        d += 4;
+        s += 4;
+        size -= 4;
+    }
+    while (size >= 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i *) (s + 0));
+        __m256i b = _mm256_loadu_si256((const __m256i *) (s + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i *) (s + 64));
+        __m256i e = _mm256_loadu_si256((const __m256i *) (s + 96));
+
+        _mm256_stream_si256((__m256i *) (d + 0), a);
+        _mm256_stream_si256((__m256i *) (d + 32), b);
+        _mm256_stream_si256((__m256i *) (d + 64), c);
+        _mm256_stream_si256((__m256i *) (d + 96), e);
+        d += 128;
+        s += 128;
+        size -= 128;
+    }
+    while (size >= 32) {
+        _mm256_stream_si256((__m256i *) d,
+                            _mm256_loadu_si256((const __m256i *) s));
+        d += 32;
+        s += 32;
+        size -= 32;
+    }
+    _mm_sfence();
+    shadowCopyC(d, s, size);
+}
+#endif
+
+#ifdef SHADOW_COPY_NEON
+/*
+ * There is no streaming store intrinsic on ARM; the frame buffer mapping
+ * is write-combined already, so plain wide stores gather just as well.
+ */
+static void
+shadowCopyNEON(void *dst, const void *src, CARD32 size)
+{
+    CARD8 *d = dst;
+
+    const CARD8 *s = src;
+
+    if (size < SHADOW_COPY_MIN) {
+        shadowCopyC(dst, src, size);
+        return;
+    }
+    while (size >= 64) {
+        uint8x16_t a = vld1q_u8(s + 0);
+        uint8x16_t b = vld1q_u8(s + 16);
+        uint8x16_t c = vld1q_u8(s + 32);
+        uint8x16_t e = vld1q_u8(s + 48);
+
+        vst1q_u8(d + 0, a);
+        vst1q_u8(d + 16, b);
+        vst1q_u8(d + 32, c);
+        vst1q_u8(d + 48, e);
+        d += 64;
+        s += 64;
+        size -= 64;
+    }
+    while (size >= 16) {
+        vst1q_u8(d, vld1q_u8(s));
+        d += 16;
+        s += 16;
+        size -= 16;
+    }
+    shadowCopyC(d, s, size);
+}
+#endif
+
+ShadowCopyProc shadowCopyLine = shadowCopyC;
+
+void
+shadowCopyInit(void)
+{
+    static Bool initialized;
+
+    if (initialized)
+        return;
+    initialized = TRUE;
+
+#ifdef SHADOW_COPY_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        shadowCopyLine = shadowCopyAVX2;
+    else if (__builtin_cpu_supports("sse2"))
+        shadowCopyLine = shadowCopySSE2;
+#endif
+#ifdef SHADOW_COPY_NEON
+    shadowCopyLine = shadowCopyNEON;
+#endif
+}
@@ -0,0 +1,434 @@
+/*
+ *
+ * Copyright © 2026 Ace Husky <acehusky12@gmail.com>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of Ace Husky not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  Ace Husky makes no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * ACE HUSKY DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL ACE HUSKY BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Cursor plane.
+ *
+ * With a shadow framebuffer the software cursor doesn't have to live in
+ * the shadow at all.  shadowCursorInit gives miPointer a sprite which
+ * only remembers which cursor is where: moving it adds the old and new
+ * cursor boxes to the shadow damage and that is all, so rendering never
+ * has to take the cursor down and put it back up.  When a flush covers
+ * any of the cursor, the pixels underneath are saved, the cursor is
+ * blended into the shadow, the update proc copies it out with the rest of
+ * the damage and the saved pixels go straight back.  Anything reading the
+ * screen back never sees the cursor.
+ *
+ * Only TrueColor root visuals with whole byte pixels are handled;
+ * shadowCursorInit fails on anything else and the caller falls back to
+ * miDCInitialize.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include    <X11/X.h>
+#include    "scrnintstr.h"
+#include    "pixmapstr.h"
+#include    "cursorstr.h"
+#include    "regionstr.h"
+#include    "servermd.h"
+#include    "mipointer.h"
+#include    "shadow.h"
+
+#if BITMAP_BIT_ORDER == MSBFirst
+#define CursorBit(line, x)  ((line)[(x) >> 3] & (0x80 >> ((x) & 7)))
+#else
+#define CursorBit(line, x)  ((line)[(x) >> 3] & (1 << ((x) & 7)))
+#endif
+
+typedef struct _shadowCursorChannel {
+    int shift;
+    CARD32 max;
+} shadowCursorChannelRec;
+
+typedef struct _shadowCursor {
+    CursorPtr pCursor;          /* NULL while hidden */
+    int x, y;                   /* hot spot */
+
+    /* red, green, blue of the root visual */
+    shadowCursorChannelRec channels[3];
+    CARD32 other;
+
+    /* what the cursor was blended over during the current flush */
+    BoxRec saved;
+    CARD8 *save;
+    int saveSize;
+} shadowCursorRec, *shadowCursorPtr;
+
+#define shadowGetCursor(pScr)	((shadowCursorPtr) shadowGetBuf(pScr)->cursor)
+
+/*
+ * Where the cursor covers the screen; FALSE when nothing of it shows.
+ */
+static Bool
+shadowCursorBox(ScreenPtr pScreen, shadowCursorPtr pCur, BoxPtr pBox)
+{
+    CursorBitsPtr bits;
+
+    if (!pCur->pCursor)
+        return FALSE;
+    bits = pCur->pCursor->bits;
+    pBox->x1 = max(pCur->x - (int) bits->xhot, 0);
+    pBox->y1 = max(pCur->y - (int) bits->yhot, 0);
+    pBox->x2 = min(pCur->x - (int) bits->xhot + bits->width, pScreen->width);
+    pBox->y2 = min(pCur->y - (int) bits->yhot + bits->height,
+                   pScreen->height);
+    return pBox->x1 < pBox->x2 && pBox->y1 < pBox->y2;
+}
+
+static void
+shadowCursorDamage(ScreenPtr pScreen, shadowCursorPtr pCur)
+{
+    shadowBuf(pScreen);
+    RegionPtr pDamage;
+
+    RegionRec region;
+
+    BoxRec box;
+
+    if (!pBuf->pPixmap || !shadowCursorBox(pScreen, pCur, &box))
+        return;
+    pDamage = DamageRegion(pBuf->pDamage);
+    REGION_INIT(&region, &box, 1);
+    REGION_UNION(pDamage, pDamage, &region);
+    REGION_UNINIT(&region);
+}
+
+/*
+ * Cursors are kept as premultiplied ARGB, core cursors with their colors
+ * already applied; recoloring realizes them again.
+ */
+static Bool
+shadowCursorRealize(ScreenPtr pScreen, CursorPtr pCursor)
+{
+    shadowCursorPtr pCur = shadowGetCursor(pScreen);
+
+    CursorBitsPtr bits = pCursor->bits;
+
+    int stride = BitmapBytePad(bits->width);
+
+    CARD32 *argb, fg, bg;
+
+    int x, y;
+
+    argb = malloc(max(bits->width * bits->height, 1) * sizeof(CARD32));
+    if (!argb)
+        return FALSE;
+#ifdef ARGB_CURSOR
+    if (bits->argb)
+        memcpy(argb, bits->argb, bits->width * bits->height * sizeof(CARD32));
+    else
+#endif
+    {
+        fg = 0xff000000 | ((pCursor->foreRed & 0xff00) << 8) |
+            (pCursor->foreGreen & 0xff00) | (pCursor->foreBlue >> 8);
+        bg = 0xff000000 | ((pCursor->backRed & 0xff00) << 8) |
+            (pCursor->backGreen & 0xff00) | (pCursor->backBlue >> 8);
+        for (y = 0; y < bits->height; y++) {
+            unsigned char *source = bits->source + y * stride;
+
+            unsigned char *mask = bits->mask + y * stride;
+
+            for (x = 0; x < bits->width; x++)
+                argb[y * bits->width + x] = !CursorBit(mask, x) ? 0 :
+                    CursorBit(source, x) ? fg : bg;
+        }
+    }
+    pCursor->devPriv[pScreen->myNum] = argb;
+    if (pCur->pCursor == pCursor)
+        shadowCursorDamage(pScreen, pCur);
+    return TRUE;
+}
+
+static Bool
+shadowCursorUnrealize(ScreenPtr pScreen, CursorPtr pCursor)
+{
+    free(pCursor->devPriv[pScreen->myNum]);
+    pCursor->devPriv[pScreen->myNum] = NULL;
+    return TRUE;
+}
+
+static void
+shadowCursorSet(ScreenPtr pScreen, CursorPtr pCursor, int x, int y)
+{
+    shadowCursorPtr pCur = shadowGetCursor(pScreen);
+
+    shadowCursorDamage(pScreen, pCur);
+    pCur->pCursor = pCursor;
+    pCur->x = x;
+    pCur->y = y;
+    shadowCursorDamage(pScreen, pCur);
+}
+
+static void
+shadowCursorMove(ScreenPtr pScreen, int x, int y)
+{
+    shadowCursorPtr pCur = shadowGetCursor(pScreen);
+
+    if (x == pCur->x && y == pCur->y)
+        return;
+    shadowCursorSet(pScreen, pCur->pCursor, x, y);
+}
+
+static const miPointerSpriteFuncRec shadowCursorFuncs = {
+    shadowCursorRealize,
+    shadowCursorUnrealize,
+    shadowCursorSet,
+    shadowCursorMove,
+};
+
+static CARD32
+shadowCursorFetch(CARD8 *p, int bytes)
+{
+    switch (bytes) {
+    case 1:
+        return *p;
+    case 2:
+        return *(CARD16 *) p;
+    case 3:
+#if IMAGE_BYTE_ORDER == MSBFirst
+        return (p[0] << 16) | (p[1] << 8) | p[2];
+#else
+        return p[0] | (p[1] << 8) | (p[2] << 16);
+#endif
+    }
+    return *(CARD32 *) p;
+}
+
+static void
+shadowCursorStore(CARD8 *p, int bytes, CARD32 pixel)
+{
+    switch (bytes) {
+    case 1:
+        *p = pixel;
+        break;
+    case 2:
+        *(CARD16 *) p = pixel;
+        break;
+    case 3:
+#if IMAGE_BYTE_ORDER == MSBFirst
+        p[0] = pixel >> 16;
+        p[1] = pixel >> 8;
+        p[2] = pixel;
+#else
+        p[0] = pixel;
+        p[1] = pixel >> 8;
+        p[2] = pixel >> 16;
+#endif
+        break;
+    default:
+        *(CARD32 *) p = pixel;
+        break;
+    }
+}
+
+/* src OVER dst, dst being a pixel of the root visual */
+static CARD32
+shadowCursorBlend(shadowCursorPtr pCur, CARD32 dst, CARD32 src)
+{
+    CARD32 a = src >> 24, pixel = dst & pCur->other;
+
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        shadowCursorChannelRec *c = &pCur->channels[i];
+
+        CARD32 s = (src >> (16 - 8 * i)) & 0xff;
+
+        if (a != 0xff) {
+            CARD32 d = ((dst >> c->shift) & c->max) * 255 / c->max;
+
+            s = min(s + (d * (255 - a) + 127) / 255, 255);
+        }
+        pixel |= ((s * c->max + 127) / 255) << c->shift;
+    }
+    return pixel;
+}
+
+/*
+ * Blend the cursor into the shadow if the damage about to be flushed
+ * touches it, keeping what was underneath for shadowCursorRestore.
+ */
+Bool
+shadowCursorPaint(ScreenPtr pScreen, shadowBufPtr pBuf, RegionPtr pRegion)
+{
+    shadowCursorPtr pCur = pBuf->cursor;
+
+    PixmapPtr pPixmap = pBuf->pPixmap;
+
+    CursorBitsPtr bits;
+
+    CARD32 *argb;
+
+    CARD8 *line, *save;
+
+    BoxRec box;
+
+    int bytes, rowBytes, size, x, y;
+
+    if (!pCur || !shadowCursorBox(pScreen, pCur, &box))
+        return FALSE;
+    bits = pCur->pCursor->bits;
+    argb = pCur->pCursor->devPriv[pScreen->myNum];
+    bytes = pPixmap->drawable.bitsPerPixel >> 3;
+    if (!argb || (pPixmap->drawable.bitsPerPixel & 7) ||
+        box.x2 > pPixmap->drawable.width ||
+        box.y2 > pPixmap->drawable.height ||
+        RECT_IN_REGION(pRegion, &box) == rgnOUT)
+        return FALSE;
+
+    rowBytes = (box.x2 - box.x1) * bytes;
+    size = rowBytes * (box.y2 - box.y1);
+    if (size > pCur->saveSize) {
+        save = realloc(pCur->save, size);
+        if (!save)
+            return FALSE;
+        pCur->save = save;
+        pCur->saveSize = size;
+    }
+
+    line = (CARD8 *) pPixmap->devPrivate.ptr + box.y1 * pPixmap->devKind +
+        box.x1 * bytes;
+    save = pCur->save;
+    argb += (box.y1 - (pCur->y - bits->yhot)) * bits->width +
+        (box.x1 - (pCur->x - bits->xhot));
+    for (y = box.y1; y < box.y2; y++) {
+        CARD8 *p = line;
+
+        memcpy(save, line, rowBytes);
+        for (x = 0; x < box.x2 - box.x1; x++, p += bytes) {
+            CARD32 src = argb[x];
+
+            if (src >> 24)
+                shadowCursorStore(p, bytes,
+                                  shadowCursorBlend(pCur,
+                                                    shadowCursorFetch(p, bytes),
+                                                    src));
+        }
+        save += rowBytes;
+        line += pPixmap->devKind;
+        argb += bits->width;
+    }
+    pCur->saved = box;
+    return TRUE;
+}
+
+/*
+ * Put back what shadowCursorPaint covered, once the update is done with
+ * the shadow.
+ */
+void
+shadowCursorRestore(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    shadowCursorPtr pCur = pBuf->cursor;
+
+    PixmapPtr pPixmap = pBuf->pPixmap;
+
+    int bytes = pPixmap->drawable.bitsPerPixel >> 3;
+
+    int rowBytes = (pCur->saved.x2 - pCur->saved.x1) * bytes;
+
+    CARD8 *line, *save = pCur->save;
+
+    int y;
+
+    line = (CARD8 *) pPixmap->devPrivate.ptr +
+        pCur->saved.y1 * pPixmap->devKind + pCur->saved.x1 * bytes;
+    for (y = pCur->saved.y1; y < pCur->saved.y2; y++) {
+        memcpy(line, save, rowBytes);
+        save += rowBytes;
+        line += pPixmap->devKind;
+    }
+}
+
+static void
+shadowCursorChannel(shadowCursorChannelRec *c, unsigned long mask)
+{
+    c->shift = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        c->shift++;
+    }
+    c->max = mask;
+}
+
+/*
+ * Use the cursor plane for the software cursor of a screen set up with
+ * shadowSetup, in place of miDCInitialize.
+ */
+Bool
+shadowCursorInit(ScreenPtr pScreen, miPointerScreenFuncPtr screenFuncs)
+{
+    shadowBuf(pScreen);
+    shadowCursorPtr pCur;
+
+    VisualPtr pVisual;
+
+    int bpp = BitsPerPixel(pScreen->rootDepth);
+
+    int i;
+
+    if (!pBuf)
+        return FALSE;
+    for (i = 0; i < pScreen->numVisuals; i++)
+        if (pScreen->visuals[i].vid == pScreen->rootVisual)
+            break;
+    if (i == pScreen->numVisuals)
+        return FALSE;
+    pVisual = &pScreen->visuals[i];
+    if (pVisual->class != TrueColor || (bpp & 7) || bpp > 32 ||
+        !pVisual->redMask || !pVisual->greenMask || !pVisual->blueMask)
+        return FALSE;
+
+    pCur = calloc(1, sizeof(shadowCursorRec));
+    if (!pCur)
+        return FALSE;
+    shadowCursorChannel(&pCur->channels[0], pVisual->redMask);
+    shadowCursorChannel(&pCur->channels[1], pVisual->greenMask);
+    shadowCursorChannel(&pCur->channels[2], pVisual->blueMask);
+    pCur->other = ~(pVisual->redMask | pVisual->greenMask | pVisual->blueMask);
+    pBuf->cursor = pCur;
+    if (!miPointerInitialize(pScreen, &shadowCursorFuncs, screenFuncs, TRUE)) {
+        pBuf->cursor = NULL;
+        free(pCur);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void
+shadowCursorDestroy(shadowBufPtr pBuf)
+{
+    shadowCursorPtr pCur = pBuf->cursor;
+
+    if (!pCur)
+        return;
+    free(pCur->save);
+    free(pCur);
+    pBuf->cursor = NULL;
+}
@@ -110,8 +110,8 @@ shadowUpdatePacked(ScreenPtr pScreen, shadowBufPtr pBuf)
                     i = width;
                 width -= i;
                 scr += i;
-                while (i--)
-                    *win++ = *sha++;
+                (*shadowCopyLine) (win, sha, i * sizeof(FbBits));
+                sha += i;
             }
             shaLine += shaStride;
             y++;
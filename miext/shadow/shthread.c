@@ -0,0 +1,253 @@
+/*
+ *
+ * Copyright © 2026 Ace Husky <acehusky12@gmail.com>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of Ace Husky not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  Ace Husky makes no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * ACE HUSKY DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL ACE HUSKY BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Threaded shadow updates.
+ *
+ * The shadow pixmap is cut into horizontal bands, one per worker.  Each
+ * flush hands every worker the part of the damage falling in its band and
+ * runs the regular update proc on that piece.  Since a band always goes
+ * to the same worker, copies of the same rows stay ordered; the dispatch
+ * thread only blocks when new damage lands in a band whose previous copy
+ * is still running.
+ *
+ * Only window procs that are pure address computations may be used this
+ * way; banked and planar windows program the hardware and must stay on
+ * the main thread.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdlib.h>
+
+#include    <X11/X.h>
+#include    "scrnintstr.h"
+#include    "windowstr.h"
+#include    "regionstr.h"
+#include    "shadow.h"
+
+#ifdef SHADOW_THREADS
+
+#include <pthread.h>
+#include <signal.h>
+
+typedef struct _shadowWorker {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    Bool busy;
+    Bool quit;
+    BoxRec band;
+    ScreenPtr pScreen;
+    shadowBufRec buf;
+    DamageRec damage;
+} shadowWorkerRec, *shadowWorkerPtr;
+
+typedef struct _shadowThreads {
+    int nworkers;
+    shadowWorkerRec workers[0];
+} shadowThreadsRec, *shadowThreadsPtr;
+
+static void *
+shadowWorkerMain(void *arg)
+{
+    shadowWorkerPtr pWorker = arg;
+
+    pthread_mutex_lock(&pWorker->lock);
+    for (;;) {
+        while (!pWorker->busy && !pWorker->quit)
+            pthread_cond_wait(&pWorker->cond, &pWorker->lock);
+        if (pWorker->quit)
+            break;
+        pthread_mutex_unlock(&pWorker->lock);
+
+        (*pWorker->buf.update) (pWorker->pScreen, &pWorker->buf);
+
+        pthread_mutex_lock(&pWorker->lock);
+        pWorker->busy = FALSE;
+        pthread_cond_broadcast(&pWorker->cond);
+    }
+    pthread_mutex_unlock(&pWorker->lock);
+    return NULL;
+}
+
+static void
+shadowWorkerWait(shadowWorkerPtr pWorker)
+{
+    pthread_mutex_lock(&pWorker->lock);
+    while (pWorker->busy)
+        pthread_cond_wait(&pWorker->cond, &pWorker->lock);
+    pthread_mutex_unlock(&pWorker->lock);
+}
+
+static void
+shadowThreadsDestroy(shadowThreadsPtr pThreads, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        shadowWorkerPtr pWorker = &pThreads->workers[i];
+
+        pthread_mutex_lock(&pWorker->lock);
+        pWorker->quit = TRUE;
+        pthread_cond_broadcast(&pWorker->cond);
+        pthread_mutex_unlock(&pWorker->lock);
+        pthread_join(pWorker->thread, NULL);
+        pthread_cond_destroy(&pWorker->cond);
+        pthread_mutex_destroy(&pWorker->lock);
+        REGION_UNINIT(&pWorker->damage.damage);
+    }
+    free(pThreads);
+}
+
+void
+shadowSync(ScreenPtr pScreen)
+{
+    shadowBuf(pScreen);
+    shadowThreadsPtr pThreads;
+
+    int i;
+
+    if (!pBuf || !pBuf->threads)
+        return;
+    pThreads = pBuf->threads;
+    for (i = 0; i < pThreads->nworkers; i++)
+        shadowWorkerWait(&pThreads->workers[i]);
+}
+
+Bool
+shadowSetThreads(ScreenPtr pScreen, int nthreads)
+{
+    shadowBuf(pScreen);
+    shadowThreadsPtr pThreads;
+
+    sigset_t set, old;
+
+    int i, height, bandHeight;
+
+    if (pBuf->threads) {
+        pThreads = pBuf->threads;
+        shadowThreadsDestroy(pThreads, pThreads->nworkers);
+        pBuf->threads = NULL;
+    }
+    if (nthreads < 2 || !pBuf->pPixmap)
+        return TRUE;
+
+    height = pBuf->pPixmap->drawable.height;
+    bandHeight = (height + nthreads - 1) / nthreads;
+
+    pThreads = calloc(1, sizeof(shadowThreadsRec) +
+                      nthreads * sizeof(shadowWorkerRec));
+    if (!pThreads)
+        return FALSE;
+    pThreads->nworkers = nthreads;
+
+    /* signals stay with the dispatch thread */
+    sigfillset(&set);
+    pthread_sigmask(SIG_SETMASK, &set, &old);
+    for (i = 0; i < nthreads; i++) {
+        shadowWorkerPtr pWorker = &pThreads->workers[i];
+
+        pWorker->pScreen = pScreen;
+        pWorker->band.x1 = 0;
+        pWorker->band.x2 = pBuf->pPixmap->drawable.width;
+        pWorker->band.y1 = i * bandHeight;
+        pWorker->band.y2 = min(height, (i + 1) * bandHeight);
+        REGION_NULL(&pWorker->damage.damage);
+        pthread_mutex_init(&pWorker->lock, NULL);
+        pthread_cond_init(&pWorker->cond, NULL);
+        if (pthread_create(&pWorker->thread, NULL, shadowWorkerMain,
+                           pWorker)) {
+            pthread_cond_destroy(&pWorker->cond);
+            pthread_mutex_destroy(&pWorker->lock);
+            REGION_UNINIT(&pWorker->damage.damage);
+            pthread_sigmask(SIG_SETMASK, &old, NULL);
+            shadowThreadsDestroy(pThreads, i);
+            return FALSE;
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    pBuf->threads = pThreads;
+    return TRUE;
+}
+
+void
+shadowThreadsUpdate(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    shadowThreadsPtr pThreads = pBuf->threads;
+
+    RegionPtr pRegion = shadowDamage(pBuf);
+
+    BoxPtr pExtents = REGION_EXTENTS(pRegion);
+
+    RegionRec band;
+
+    int i;
+
+    for (i = 0; i < pThreads->nworkers; i++) {
+        shadowWorkerPtr pWorker = &pThreads->workers[i];
+
+        if (pExtents->y2 <= pWorker->band.y1 ||
+            pExtents->y1 >= pWorker->band.y2)
+            continue;
+
+        REGION_INIT(&band, &pWorker->band, 1);
+        shadowWorkerWait(pWorker);
+        REGION_INTERSECT(&pWorker->damage.damage, pRegion, &band);
+        REGION_UNINIT(&band);
+        if (!REGION_NOTEMPTY(&pWorker->damage.damage))
+            continue;
+
+        pWorker->buf = *pBuf;
+        pWorker->buf.pDamage = &pWorker->damage;
+        pWorker->buf.threads = NULL;
+
+        pthread_mutex_lock(&pWorker->lock);
+        pWorker->busy = TRUE;
+        pthread_cond_broadcast(&pWorker->cond);
+        pthread_mutex_unlock(&pWorker->lock);
+    }
+}
+
+#else
+
+void
+shadowSync(ScreenPtr pScreen)
+{
+}
+
+Bool
+shadowSetThreads(ScreenPtr pScreen, int nthreads)
+{
+    return nthreads < 2;
+}
+
+void
+shadowThreadsUpdate(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    (*pBuf->update) (pScreen, pBuf);
+}
+
+#endif
@@ -0,0 +1,236 @@
+/*
+ *
+ * Copyright © 2026 Ace Husky <acehusky12@gmail.com>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of Ace Husky not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  Ace Husky makes no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * ACE HUSKY DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL ACE HUSKY BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Tile coalescing of shadow damage.
+ *
+ * Text and span heavy clients leave hundreds of tiny boxes in the damage
+ * region, and every one of them costs a window lookup per scanline in the
+ * update procs.  When a region gets that fragmented it is rounded out to
+ * SHADOW_TILE_SIZE square tiles instead; runs of dirty tiles on a tile
+ * row become a single box and identical neighbouring rows are merged, so
+ * the flush is bounded by the number of dirty tiles.  Tile edges are
+ * multiples of 64 pixels and therefore always fall on cache lines.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include    <X11/X.h>
+#include    "scrnintstr.h"
+#include    "pixmapstr.h"
+#include    "regionstr.h"
+#include    "shadow.h"
+
+#define SHADOW_TILE_SHIFT	6
+#define SHADOW_TILE_SIZE	(1 << SHADOW_TILE_SHIFT)
+
+/* Regions with at most this many boxes are copied as they are */
+#define SHADOW_TILE_BOXES	32
+
+typedef struct _shadowTiles {
+    int width, height;
+    int cols, rows;
+    int stride;
+    BoxPtr boxes;
+    CARD32 bits[0];
+} shadowTilesRec, *shadowTilesPtr;
+
+#define TileRow(t, y)		((t)->bits + (y) * (t)->stride)
+#define TileIsSet(row, x)	((row)[(x) >> 5] & (1U << ((x) & 31)))
+
+static shadowTilesPtr
+shadowTilesCreate(int width, int height)
+{
+    shadowTilesPtr pTiles;
+
+    int cols = (width + SHADOW_TILE_SIZE - 1) >> SHADOW_TILE_SHIFT;
+
+    int rows = (height + SHADOW_TILE_SIZE - 1) >> SHADOW_TILE_SHIFT;
+
+    int stride = (cols + 31) >> 5;
+
+    pTiles = malloc(sizeof(shadowTilesRec) +
+                    rows * stride * sizeof(CARD32) +
+                    rows * ((cols + 1) / 2) * sizeof(BoxRec));
+    if (!pTiles)
+        return NULL;
+    pTiles->width = width;
+    pTiles->height = height;
+    pTiles->cols = cols;
+    pTiles->rows = rows;
+    pTiles->stride = stride;
+    pTiles->boxes = (BoxPtr) (pTiles->bits + rows * stride);
+    return pTiles;
+}
+
+void
+shadowTilesDestroy(shadowBufPtr pBuf)
+{
+    free(pBuf->tiles);
+    pBuf->tiles = NULL;
+}
+
+static void
+shadowTilesMark(CARD32 *row, int x1, int x2)
+{
+    for (; x1 <= x2 && (x1 & 31); x1++)
+        row[x1 >> 5] |= 1U << (x1 & 31);
+    for (; x1 + 31 <= x2; x1 += 32)
+        row[x1 >> 5] = ~0U;
+    for (; x1 <= x2; x1++)
+        row[x1 >> 5] |= 1U << (x1 & 31);
+}
+
+void
+shadowTileDamage(shadowBufPtr pBuf, RegionPtr pRegion)
+{
+    shadowTilesPtr pTiles = pBuf->tiles;
+
+    DrawablePtr pDraw = &pBuf->pPixmap->drawable;
+
+    int nbox = REGION_NUM_RECTS(pRegion);
+
+    BoxPtr pbox = REGION_RECTS(pRegion);
+
+    BoxPtr pExtents = REGION_EXTENTS(pRegion);
+
+    BoxPtr pOut, pPrev = NULL;
+
+    int nPrev = 0, nOut;
+
+    int ty1, ty2, tx1, tx2, x, y;
+
+    CARD32 *row;
+
+    if (nbox <= SHADOW_TILE_BOXES)
+        return;
+
+    if (!pTiles || pTiles->width != pDraw->width ||
+        pTiles->height != pDraw->height) {
+        shadowTilesDestroy(pBuf);
+        pTiles = pBuf->tiles = shadowTilesCreate(pDraw->width, pDraw->height);
+        if (!pTiles)
+            return;
+    }
+
+    ty1 = max(pExtents->y1, 0) >> SHADOW_TILE_SHIFT;
+    ty2 = (min(pExtents->y2, pDraw->height) - 1) >> SHADOW_TILE_SHIFT;
+    if (ty2 < ty1)
+        return;
+    memset(TileRow(pTiles, ty1), 0,
+           (ty2 - ty1 + 1) * pTiles->stride * sizeof(CARD32));
+
+    for (; nbox--; pbox++) {
+        int by1 = max(pbox->y1, 0) >> SHADOW_TILE_SHIFT;
+
+        int by2 = (min(pbox->y2, pDraw->height) - 1) >> SHADOW_TILE_SHIFT;
+
+        tx1 = max(pbox->x1, 0) >> SHADOW_TILE_SHIFT;
+        tx2 = (min(pbox->x2, pDraw->width) - 1) >> SHADOW_TILE_SHIFT;
+        if (tx2 < tx1)
+            continue;
+        for (y = by1; y <= by2; y++)
+            shadowTilesMark(TileRow(pTiles, y), tx1, tx2);
+    }
+
+    /*
+     * Walk the tile rows turning runs into boxes; a row whose runs
+     * match the previous row just stretches those boxes down.
+     */
+    pOut = pTiles->boxes;
+    for (y = ty1; y <= ty2; y++) {
+        BoxPtr pRow = pOut;
+
+        int y1 = y << SHADOW_TILE_SHIFT;
+
+        int y2 = min(y1 + SHADOW_TILE_SIZE, pDraw->height);
+
+        int n;
+
+        row = TileRow(pTiles, y);
+        for (x = 0; x < pTiles->cols;) {
+            if (!row[x >> 5] && !(x & 31)) {
+                x += 32;
+                continue;
+            }
+            if (!TileIsSet(row, x)) {
+                x++;
+                continue;
+            }
+            tx1 = x;
+            while (x < pTiles->cols && TileIsSet(row, x))
+                x++;
+            pOut->x1 = tx1 << SHADOW_TILE_SHIFT;
+            pOut->x2 = min(x << SHADOW_TILE_SHIFT, pDraw->width);
+            pOut->y1 = y1;
+            pOut->y2 = y2;
+            pOut++;
+        }
+        n = pOut - pRow;
+        if (!n)
+            continue;
+        if (pPrev && n == nPrev && pPrev->y2 == y1) {
+            int i;
+
+            for (i = 0; i < n; i++)
+                if (pPrev[i].x1 != pRow[i].x1 || pPrev[i].x2 != pRow[i].x2)
+                    break;
+            if (i == n) {
+                for (i = 0; i < n; i++)
+                    pPrev[i].y2 = y2;
+                pOut = pRow;
+                continue;
+            }
+        }
+        pPrev = pRow;
+        nPrev = n;
+    }
+
+    nOut = pOut - pTiles->boxes;
+    if (!nOut || nOut >= REGION_NUM_RECTS(pRegion))
+        return;
+
+    REGION_UNINIT(pRegion);
+    pRegion->extents.x1 = MAXSHORT;
+    pRegion->extents.x2 = MINSHORT;
+    for (pbox = pTiles->boxes; pbox < pOut; pbox++) {
+        pRegion->extents.x1 = min(pRegion->extents.x1, pbox->x1);
+        pRegion->extents.x2 = max(pRegion->extents.x2, pbox->x2);
+    }
+    pRegion->extents.y1 = pTiles->boxes[0].y1;
+    pRegion->extents.y2 = pOut[-1].y2;
+
+    /* a single box, or no memory: the bounding tiles still cover it all */
+    if (nOut == 1 || !(pRegion->data = malloc(REGION_SZOF(nOut)))) {
+        pRegion->data = NULL;
+        return;
+    }
+    pRegion->data->size = nOut;
+    pRegion->data->numRects = nOut;
+    memcpy(REGION_BOXPTR(pRegion), pTiles->boxes, nOut * sizeof(BoxRec));
+}
@@ -152,6 +152,16 @@ WaitForSomething(int *pClientsReady)
 	/* deal with any blocked jobs */
 	if (workQueue)
 	    ProcessWorkQueue();
+	if (ClientStatsPending)
+	{
+	    ClientStatsPending = FALSE;
+	    ClientStatsDump();
+	}
+	if (DispatchTracePending)
+	{
+	    DispatchTracePending = FALSE;
+	    DispatchTraceDump();
+	}
 	if (XFD_ANYSET (&ClientsWithInput))
 	{
 #ifdef SMART_SCHEDULE
@@ -201,7 +211,6 @@ WaitForSomething(int *pClientsReady)
 	XFD_COPYSET(&AllSockets, &LastSelectMask);
 #ifdef SMART_SCHEDULE
 	}
-	SmartScheduleIdle = TRUE;
 #endif
 	BlockHandler((pointer)&wt, (pointer)&LastSelectMask);
 	if (NewOutputPending)
@@ -212,23 +221,14 @@ WaitForSomething(int *pClientsReady)
 	else if (AnyClientsWriteBlocked)
 	{
 	    XFD_COPYSET(&ClientsWriteBlocked, &clientsWritable);
-	    i = Select (MaxClients, &LastSelectMask, &clientsWritable, NULL, wt);
+	    i = OsPoll (MaxClients, &LastSelectMask, &clientsWritable, wt);
 	}
 	else
 	{
-	    i = Select (MaxClients, &LastSelectMask, NULL, NULL, wt);
+	    i = OsPoll (MaxClients, &LastSelectMask, NULL, wt);
 	}
 	selecterr = GetErrno();
 	WakeupHandler(i, (pointer)&LastSelectMask);
-#ifdef SMART_SCHEDULE
-	if (i >= 0)
-	{
-	    SmartScheduleIdle = FALSE;
-	    SmartScheduleIdleCount = 0;
-	    if (SmartScheduleTimerStopped)
-		(void) SmartScheduleStartTimer ();
-	}
-#endif
 	if (i <= 0) /* An error or timeout occurred */
 	{
 	    if (dispatchException)
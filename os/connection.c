@@ -282,13 +282,14 @@ CreateWellKnownSockets(void)
     handler = OsSignal (SIGUSR1, SIG_IGN);
     if ( handler == SIG_IGN)
 	RunFromSmartParent = TRUE;
-    OsSignal(SIGUSR1, handler);
     ParentProcess = getppid ();
     if (RunFromSmartParent) {
 	if (ParentProcess > 1) {
 	    kill (ParentProcess, SIGUSR1);
 	}
     }
+    /* SIGUSR1 is the VT switch signal, the statistics go on SIGUSR2 */
+    OsSignal(SIGUSR2, DispatchStatsRequest);
 #ifdef XDMCP
     XdmcpInit ();
 #endif
@@ -314,6 +315,7 @@ ResetWellKnownSockets (void)
 		 * Remove it from out list.
 		 */
 
+		OsPollForget (ListenTransFds[i]);
 		FD_CLR (ListenTransFds[i], &WellKnownConnections);
 		ListenTransFds[i] = ListenTransFds[ListenTransCount - 1];
 		ListenTransConns[i] = ListenTransConns[ListenTransCount - 1];
@@ -328,6 +330,7 @@ ResetWellKnownSockets (void)
 
 		int newfd = _XSERVTransGetConnectionNumber (ListenTransConns[i]);
 
+		OsPollForget (ListenTransFds[i]);
 		FD_CLR (ListenTransFds[i], &WellKnownConnections);
 		ListenTransFds[i] = newfd;
 		FD_SET(newfd, &WellKnownConnections);
@@ -359,7 +362,10 @@ CloseWellKnownConnections(void)
     int i;
 
     for (i = 0; i < ListenTransCount; i++)
+    {
+	OsPollForget (ListenTransFds[i]);
 	_XSERVTransClose (ListenTransConns[i]);
+    }
 }
 
 static void
@@ -713,6 +719,7 @@ CloseDownFileDescriptor(OsCommPtr oc)
 {
     int connection = oc->fd;
 
+    OsPollForget(connection);
     if (oc->trans_conn) {
 	_XSERVTransDisconnect(oc->trans_conn);
 	_XSERVTransClose(oc->trans_conn);
@@ -781,7 +788,7 @@ static void FreeOsBuffers(OsCommPtr oc) {
 	if (AvailableInput == oc)
 		AvailableInput = (OsCommPtr)NULL;
 	if ((oci = oc->input)) {
-		if (FreeInputs) {
+		if (FreeInputs || oci->size > BUFWATERMARK) {
 			free(oci->buffer);
 			free(oci);
 		} else {
@@ -790,6 +797,7 @@ static void FreeOsBuffers(OsCommPtr oc) {
 			oci->bufptr = oci->buffer;
 			oci->bufcnt = 0;
 			oci->lenLastReq = 0;
+			oci->peak = 0;
 		}
 	}
 	if ((oco = oc->output)) {
@@ -846,6 +854,7 @@ AddEnabledDevice(int fd)
 _X_EXPORT void
 RemoveGeneralSocket(int fd)
 {
+    OsPollForget(fd);
     FD_CLR(fd, &AllSockets);
     if (GrabInProgress)
         FD_CLR(fd, &SavedAllSockets);
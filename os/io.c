@@ -68,6 +68,7 @@ SOFTWARE.
 #include <X11/Xmd.h>
 #include <errno.h>
 #include <sys/uio.h>
+#include <sys/ioctl.h>
 #include <X11/X.h>
 #include <X11/Xproto.h>
 #include "os.h"
@@ -110,6 +111,14 @@ OsCommPtr AvailableInput = (OsCommPtr)NULL;
 
 #define MAX_TIMES_PER         10
 
+/* Input buffers up to this size may stay with a client between requests */
+#define INPUT_KEEP		(64 * BUFSIZE)
+
+/* Writes this big go straight from the caller's buffer */
+#define OUTPUT_DIRECT		BUFSIZE
+/* Smaller ones are collected in a buffer that may grow this far */
+#define OUTPUT_COALESCE		(16 * BUFSIZE)
+
 /*
  *   A lot of the code in this file manipulates a ConnectionInputPtr:
  *
@@ -167,6 +176,80 @@ OsCommPtr AvailableInput = (OsCommPtr)NULL;
  *    a partial request) because others clients need to be scheduled.
  *****************************************************************/
 
+/*
+ * If an input buffer was empty, either free it if it is too big or link
+ * it into our list of free input buffers.  This means that different
+ * clients can share the same input buffer (at different times).  This
+ * was done to save memory.  A client that keeps filling a good part of
+ * a bigger buffer gets to keep it instead; peak decays each time so the
+ * buffer is let go a while after the client's requests get smaller.
+ */
+static void
+ReleaseAvailableInput(OsCommPtr oc)
+{
+    if (AvailableInput)
+    {
+	if (AvailableInput != oc)
+	{
+	    ConnectionInputPtr aci = AvailableInput->input;
+	    if (aci->size > BUFWATERMARK && aci->size <= INPUT_KEEP &&
+		aci->peak * 4 > aci->size)
+	    {
+		aci->peak >>= 1;
+	    }
+	    else
+	    {
+		if (aci->size > BUFWATERMARK)
+		{
+		    free(aci->buffer);
+		    free(aci);
+		}
+		else
+		{
+		    aci->peak = 0;
+		    aci->next = FreeInputs;
+		    FreeInputs = aci;
+		}
+		AvailableInput->input = (ConnectionInputPtr)NULL;
+	    }
+	}
+	AvailableInput = (OsCommPtr)NULL;
+    }
+}
+
+/*
+ * Move the gotnow bytes at bufptr to the start of the buffer, first
+ * replacing the buffer with one of at least size bytes if it is smaller.
+ * Sizes go up in powers of two so a client whose requests keep getting a
+ * little bigger doesn't reallocate each time; the unread bytes are all
+ * that is copied.
+ */
+static Bool
+ResizeInputBuffer(ConnectionInputPtr oci, int gotnow, int size)
+{
+    if (size > oci->size)
+    {
+	char *ibuf;
+	int newsize = BUFSIZE;
+
+	while (newsize < size)
+	    newsize <<= 1;
+	ibuf = (char *)malloc(newsize);
+	if (!ibuf)
+	    return FALSE;
+	if (gotnow > 0)
+	    memcpy(ibuf, oci->bufptr, gotnow);
+	free(oci->buffer);
+	oci->buffer = ibuf;
+	oci->size = newsize;
+    }
+    else if ((gotnow > 0) && (oci->bufptr != oci->buffer))
+	memmove(oci->buffer, oci->bufptr, gotnow);
+    oci->bufptr = oci->buffer;
+    oci->bufcnt = gotnow;
+    return TRUE;
+}
+
 #define YieldControl()				\
         { isItTimeToYield = TRUE;		\
 	  timesThisConnection = 0; }
@@ -188,31 +271,7 @@ ReadRequestFromClient(ClientPtr client)
     Bool need_header;
     Bool move_header;
 
-    /* If an input buffer was empty, either free it if it is too big
-     * or link it into our list of free input buffers.  This means that
-     * different clients can share the same input buffer (at different
-     * times).  This was done to save memory.
-     */
-
-    if (AvailableInput)
-    {
-	if (AvailableInput != oc)
-	{
-	    ConnectionInputPtr aci = AvailableInput->input;
-	    if (aci->size > BUFWATERMARK)
-	    {
-		free(aci->buffer);
-		free(aci);
-	    }
-	    else
-	    {
-		aci->next = FreeInputs;
-		FreeInputs = aci;
-	    }
-	    AvailableInput->input = (ConnectionInputPtr)NULL;
-	}
-	AvailableInput = (OsCommPtr)NULL;
-    }
+    ReleaseAvailableInput(oc);
 
     /* make sure we have an input buffer */
 
@@ -288,26 +347,25 @@ ReadRequestFromClient(ClientPtr client)
 	{
 	    /* no data, or the request is too big to fit in the buffer */
 
-	    if ((gotnow > 0) && (oci->bufptr != oci->buffer))
-		/* save the data we've already read */
-		memmove(oci->buffer, oci->bufptr, gotnow);
-	    if (needed > oci->size)
+	    if (!ResizeInputBuffer(oci, gotnow, needed))
 	    {
-		/* make buffer bigger to accomodate request */
-		char *ibuf;
-
-		ibuf = (char *)realloc(oci->buffer, needed);
-		if (!ibuf)
-		{
-		    YieldControlDeath();
-		    return -1;
-		}
-		oci->size = needed;
-		oci->buffer = ibuf;
+		YieldControlDeath();
+		return -1;
 	    }
-	    oci->bufptr = oci->buffer;
-	    oci->bufcnt = gotnow;
 	}
+#ifdef FIONREAD
+	/* a client that filled its buffer last time may have a lot more
+	 * queued; make room to take all of it with one read */
+	if (oci->peak >= oci->size && oci->size < INPUT_KEEP)
+	{
+	    int avail;
+
+	    if (ioctl(fd, FIONREAD, &avail) == 0 && avail > 0 &&
+		oci->bufcnt + avail > oci->size)
+		(void) ResizeInputBuffer(oci, gotnow,
+					 min(gotnow + avail, INPUT_KEEP));
+	}
+#endif
 	/*  XXX this is a workaround.  This function is sometimes called
 	 *  after the trans_conn has been freed.  In this case trans_conn
 	 *  will be null.  Really ought to restructure things so that we
@@ -323,6 +381,8 @@ ReadRequestFromClient(ClientPtr client)
 	}
 	    result = _XSERVTransRead(oc->trans_conn, oci->buffer + oci->bufcnt,
 				     oci->size - oci->bufcnt);
+	if (result > 0)
+	    client->stats.bytesRead += result;
 	if (result <= 0)
 	{
 	    if ((result < 0) && ETEST(errno))
@@ -337,20 +397,8 @@ ReadRequestFromClient(ClientPtr client)
 	}
 	oci->bufcnt += result;
 	gotnow += result;
-	/* free up some space after huge requests */
-	if ((oci->size > BUFWATERMARK) &&
-	    (oci->bufcnt < BUFSIZE) && (needed < BUFSIZE))
-	{
-	    char *ibuf;
-
-	    ibuf = (char *)realloc(oci->buffer, BUFSIZE);
-	    if (ibuf)
-	    {
-		oci->size = BUFSIZE;
-		oci->buffer = ibuf;
-		oci->bufptr = ibuf + oci->bufcnt - gotnow;
-	    }
-	}
+	if (oci->bufcnt > oci->peak)
+	    oci->peak = oci->bufcnt;
 	if (need_header && gotnow >= needed)
 	{
 	    /* We wanted an xReq, now we've gotten it. */
@@ -461,25 +509,7 @@ InsertFakeRequest(ClientPtr client, char *data, int count)
     int fd = oc->fd;
     int gotnow, moveup;
 
-    if (AvailableInput)
-    {
-	if (AvailableInput != oc)
-	{
-	    ConnectionInputPtr aci = AvailableInput->input;
-	    if (aci->size > BUFWATERMARK)
-	    {
-		free(aci->buffer);
-		free(aci);
-	    }
-	    else
-	    {
-		aci->next = FreeInputs;
-		FreeInputs = aci;
-	    }
-	    AvailableInput->input = (ConnectionInputPtr)NULL;
-	}
-	AvailableInput = (OsCommPtr)NULL;
-    }
+    ReleaseAvailableInput(oc);
     if (!oci)
     {
 	if ((oci = FreeInputs))
@@ -649,10 +679,33 @@ SetCriticalOutputPending(void)
     CriticalOutputPending = TRUE;
 }
 
+/*
+ * Make room for size bytes of output, doubling so that a client being
+ * sent a lot doesn't have its buffer reallocated for every write.
+ */
+static Bool
+GrowOutputBuffer(ConnectionOutputPtr oco, long size)
+{
+    unsigned char *obuf;
+    long newsize = oco->size;
+
+    if (size <= newsize)
+	return TRUE;
+    while (newsize < size)
+	newsize <<= 1;
+    obuf = (unsigned char *)realloc(oco->buf, newsize);
+    if (!obuf)
+	return FALSE;
+    oco->size = newsize;
+    oco->buf = obuf;
+    return TRUE;
+}
+
 /*****************
  * WriteToClient
- *    Copies buf into ClientPtr.buf if it fits (with padding), else
- *    flushes ClientPtr.buf and buf to client.  As of this writing,
+ *    Copies buf into ClientPtr.buf if it fits (with padding), growing
+ *    the buffer for small writes, else flushes ClientPtr.buf and buf
+ *    to client with a single writev.  As of this writing,
  *    every use of WriteToClient is cast to void, and the result
  *    is ignored.  Potentially, this could be used by requests
  *    that are sending several chunks of data and want to break
@@ -773,8 +826,34 @@ WriteToClient (ClientPtr who, int count, const char *buf)
 	}
     }
 #endif
-    if (oco->count == 0 || oco->count + count + padBytes > oco->size)
+    if (oco->count + count + padBytes > oco->size)
     {
+	/*
+	 * A client that isn't reading has everything queued until it
+	 * is; otherwise small writes keep being collected while the
+	 * buffer may still grow, and anything else is written out
+	 * together with what is already queued.
+	 */
+	if (FD_ISSET(oc->fd, &ClientsWriteBlocked) ||
+	    (count < OUTPUT_DIRECT && oco->size < OUTPUT_COALESCE))
+	{
+	    if (!GrowOutputBuffer(oco, oco->count + count + padBytes))
+	    {
+		if (oc->trans_conn) {
+		    _XSERVTransDisconnect(oc->trans_conn);
+		    _XSERVTransClose(oc->trans_conn);
+		    oc->trans_conn = NULL;
+		}
+		MarkClientException(who);
+		oco->count = 0;
+		return -1;
+	    }
+	    NewOutputPending = TRUE;
+	    FD_SET(oc->fd, &OutputPending);
+	    memmove((char *)oco->buf + oco->count, buf, count);
+	    oco->count += count + padBytes;
+	    return(count);
+	}
 	FD_CLR(oc->fd, &OutputPending);
 	if(!XFD_ANYSET(&OutputPending)) {
 	  CriticalOutputPending = FALSE;
@@ -790,6 +869,20 @@ WriteToClient (ClientPtr who, int count, const char *buf)
     return(count);
 }
 
+/*
+ * Microseconds the client has spent with output it wouldn't take,
+ * counting a block still in progress.
+ */
+CARD64
+ClientWriteBlockedTime(ClientPtr client)
+{
+    CARD64 blocked = client->stats.blockedTime;
+
+    if (client->stats.blockedSince)
+	blocked += GetTimeInMicros() - client->stats.blockedSince;
+    return blocked;
+}
+
  /********************
  * FlushClient()
  *    If the client isn't keeping up with us, then we try to continue
@@ -812,9 +905,11 @@ FlushClient(ClientPtr who, OsCommPtr oc, const char *extraBuf, int extraCount)
     long padsize;
     long notWritten;
     long todo;
+    long queued;
 
     if (!oco)
 	return 0;
+    queued = oco->count;
     written = 0;
     padsize = padlength[extraCount & 3];
     notWritten = oco->count + extraCount + padsize;
@@ -859,6 +954,7 @@ FlushClient(ClientPtr who, OsCommPtr oc, const char *extraBuf, int extraCount)
 	errno = 0;
 	if (trans_conn && (len = _XSERVTransWritev(trans_conn, iov, i)) >= 0)
 	{
+	    who->stats.bytesWritten += len;
 	    written += len;
 	    notWritten -= len;
 	    todo = notWritten;
@@ -874,6 +970,8 @@ FlushClient(ClientPtr who, OsCommPtr oc, const char *extraBuf, int extraCount)
 	       the rest. */
 	    FD_SET(connection, &ClientsWriteBlocked);
 	    AnyClientsWriteBlocked = TRUE;
+	    if (!who->stats.blockedSince)
+		who->stats.blockedSince = GetTimeInMicros();
 
 	    if (written < oco->count)
 	    {
@@ -892,23 +990,14 @@ FlushClient(ClientPtr who, OsCommPtr oc, const char *extraBuf, int extraCount)
 		oco->count = 0;
 	    }
 
-	    if (notWritten > oco->size)
+	    if (!GrowOutputBuffer(oco, notWritten))
 	    {
-		unsigned char *obuf;
-
-		obuf = (unsigned char *)realloc(oco->buf,
-						 notWritten + BUFSIZE);
-		if (!obuf)
-		{
-		    _XSERVTransDisconnect(oc->trans_conn);
-		    _XSERVTransClose(oc->trans_conn);
-		    oc->trans_conn = NULL;
-		    MarkClientException(who);
-		    oco->count = 0;
-		    return(-1);
-		}
-		oco->size = notWritten + BUFSIZE;
-		oco->buf = obuf;
+		_XSERVTransDisconnect(oc->trans_conn);
+		_XSERVTransClose(oc->trans_conn);
+		oc->trans_conn = NULL;
+		MarkClientException(who);
+		oco->count = 0;
+		return(-1);
 	    }
 
 	    /* If the amount written extended into the padBuffer, then the
@@ -944,6 +1033,11 @@ FlushClient(ClientPtr who, OsCommPtr oc, const char *extraBuf, int extraCount)
 
     /* everything was flushed out */
     oco->count = 0;
+    if (who->stats.blockedSince)
+    {
+	who->stats.blockedTime += GetTimeInMicros() - who->stats.blockedSince;
+	who->stats.blockedSince = 0;
+    }
     /* check to see if this client was write blocked */
     if (AnyClientsWriteBlocked)
     {
@@ -953,6 +1047,9 @@ FlushClient(ClientPtr who, OsCommPtr oc, const char *extraBuf, int extraCount)
     }
     if (oco->size > BUFWATERMARK)
     {
+	/* a client that still fills a grown buffer gets to keep it */
+	if (oco->size <= OUTPUT_COALESCE && queued * 4 >= oco->size)
+	    return extraCount;
 	free(oco->buf);
 	free(oco);
     }
@@ -983,6 +1080,7 @@ AllocateInputBuffer(void)
     oci->bufptr = oci->buffer;
     oci->bufcnt = 0;
     oci->lenLastReq = 0;
+    oci->peak = 0;
     return oci;
 }
 
@@ -114,6 +114,7 @@ typedef struct _connectionInput {
     int  bufcnt;                /* count of bytes in buffer */
     int lenLastReq;
     int size;
+    int peak;                   /* most bytes held since last let go of */
 } ConnectionInput, *ConnectionInputPtr;
 
 typedef struct _connectionOutput {
@@ -203,6 +204,11 @@ extern WorkQueuePtr workQueue;
 #define ffs mffs
 extern int mffs(fd_mask);
 
+/* in ospoll.c */
+extern int OsPoll(int maxfds, fd_set *readable, fd_set *writable,
+		  struct timeval *wt);
+extern void OsPollForget(int fd);
+
 /* in auth.c */
 extern void GenerateRandomData (int len, char *buf);
 
@@ -181,11 +181,6 @@ OsInit(void)
     TimerInit();
     OsVendorInit();
 
-#ifdef SMART_SCHEDULE
-    if (!SmartScheduleDisable)
-	if (!SmartScheduleInit ())
-	    SmartScheduleDisable = TRUE;
-#endif
     OsInitAllocator();
 }
 
@@ -0,0 +1,301 @@
+/*
+ * Copyright © 2026 Ace Husky <acehusky12@gmail.com>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of Ace Husky not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  Ace Husky makes no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * ACE HUSKY DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL ACE HUSKY BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*****************************************************************
+ * Waiting on file descriptors:
+ *
+ *  OsPoll, OsPollForget
+ *
+ * OsPoll is a drop-in for select(): the masks passed in say what to
+ * wait for and come back saying what is ready, so block and wakeup
+ * handlers keep working on fd_sets.  Underneath, the kernel keeps the
+ * set of descriptors being watched (epoll on Linux, kqueue on the BSDs)
+ * and only what changed since the last call is passed down; the
+ * difference is found a mask word at a time.  Waking up then costs in
+ * proportion to the descriptors that are ready rather than to the
+ * highest one open.
+ *
+ * A descriptor has to be forgotten before it is closed, or a new one
+ * given the same number would look as if it was already being watched.
+ * Without either kernel interface this is just select().
+ *****************************************************************/
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <X11/Xos.h>
+#include <errno.h>
+#include <X11/X.h>
+#include "misc.h"
+
+#include "osdep.h"
+#include <X11/Xpoll.h>
+
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_EPOLL_CREATE1)
+#define OS_POLL_EPOLL
+#include <sys/epoll.h>
+#elif defined(HAVE_SYS_EVENT_H) && defined(HAVE_KQUEUE)
+#define OS_POLL_KQUEUE
+#include <sys/event.h>
+#endif
+
+#if defined(OS_POLL_EPOLL) || defined(OS_POLL_KQUEUE)
+
+/* Events collected per call; any more are still pending next time */
+#define OS_POLL_EVENTS	256
+
+static int pollFd = -1;
+static Bool pollBroken;
+static fd_set pollRead;		/* what the kernel has been told */
+static fd_set pollWrite;
+
+#ifdef OS_POLL_EPOLL
+
+static struct epoll_event pollEvents[OS_POLL_EVENTS];
+
+static int
+OsPollOpen(void)
+{
+    return epoll_create1(EPOLL_CLOEXEC);
+}
+
+static int
+OsPollChange(int fd, Bool wasRead, Bool wasWrite, Bool read, Bool write)
+{
+    struct epoll_event ev;
+    int op;
+
+    ev.events = (read ? EPOLLIN : 0) | (write ? EPOLLOUT : 0);
+    ev.data.fd = fd;
+    if (!read && !write)
+	op = EPOLL_CTL_DEL;
+    else if (!wasRead && !wasWrite)
+	op = EPOLL_CTL_ADD;
+    else
+	op = EPOLL_CTL_MOD;
+    if (epoll_ctl(pollFd, op, fd, &ev) == 0)
+	return 0;
+    /* the kernel drops closed descriptors on its own */
+    if (op == EPOLL_CTL_ADD && errno == EEXIST)
+	return epoll_ctl(pollFd, EPOLL_CTL_MOD, fd, &ev);
+    if (op == EPOLL_CTL_MOD && errno == ENOENT)
+	return epoll_ctl(pollFd, EPOLL_CTL_ADD, fd, &ev);
+    if (op == EPOLL_CTL_DEL && (errno == ENOENT || errno == EBADF))
+	return 0;
+    return -1;
+}
+
+static int
+OsPollWait(fd_set *readable, fd_set *writable, int timeout)
+{
+    int n, i, ready = 0;
+
+    n = epoll_wait(pollFd, pollEvents, OS_POLL_EVENTS, timeout);
+    if (n < 0)
+	return n;
+    for (i = 0; i < n; i++)
+    {
+	int fd = pollEvents[i].data.fd;
+	unsigned int events = pollEvents[i].events;
+
+	/* errors and hangups show up as readable, as with select */
+	if ((events & (EPOLLIN|EPOLLERR|EPOLLHUP)) && FD_ISSET(fd, &pollRead))
+	{
+	    FD_SET(fd, readable);
+	    ready++;
+	}
+	if ((events & (EPOLLOUT|EPOLLERR|EPOLLHUP)) && writable &&
+	    FD_ISSET(fd, &pollWrite))
+	{
+	    FD_SET(fd, writable);
+	    ready++;
+	}
+    }
+    return ready;
+}
+
+#else /* OS_POLL_KQUEUE */
+
+static struct kevent pollEvents[OS_POLL_EVENTS];
+
+static int
+OsPollOpen(void)
+{
+    int fd = kqueue();
+
+    if (fd >= 0)
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return fd;
+}
+
+static int
+OsPollChange(int fd, Bool wasRead, Bool wasWrite, Bool read, Bool write)
+{
+    struct kevent ev[2];
+    int n = 0;
+
+    if (read != wasRead)
+	EV_SET(&ev[n++], fd, EVFILT_READ, read ? EV_ADD : EV_DELETE,
+	       0, 0, NULL);
+    if (write != wasWrite)
+	EV_SET(&ev[n++], fd, EVFILT_WRITE, write ? EV_ADD : EV_DELETE,
+	       0, 0, NULL);
+    if (kevent(pollFd, ev, n, NULL, 0, NULL) == 0)
+	return 0;
+    /* the kernel drops closed descriptors on its own */
+    if (!read && !write && (errno == ENOENT || errno == EBADF))
+	return 0;
+    return -1;
+}
+
+static int
+OsPollWait(fd_set *readable, fd_set *writable, int timeout)
+{
+    struct timespec ts, *pts = NULL;
+    int n, i, ready = 0;
+
+    if (timeout >= 0)
+    {
+	ts.tv_sec = timeout / 1000;
+	ts.tv_nsec = (timeout % 1000) * 1000000;
+	pts = &ts;
+    }
+    n = kevent(pollFd, NULL, 0, pollEvents, OS_POLL_EVENTS, pts);
+    if (n < 0)
+	return n;
+    for (i = 0; i < n; i++)
+    {
+	int fd = pollEvents[i].ident;
+
+	if (pollEvents[i].filter == EVFILT_READ && FD_ISSET(fd, &pollRead))
+	{
+	    FD_SET(fd, readable);
+	    ready++;
+	}
+	else if (pollEvents[i].filter == EVFILT_WRITE && writable &&
+		 FD_ISSET(fd, &pollWrite))
+	{
+	    FD_SET(fd, writable);
+	    ready++;
+	}
+    }
+    return ready;
+}
+
+#endif
+
+/*
+ * Bring the kernel's idea of what to watch up to date with the masks.
+ */
+static int
+OsPollSync(fd_set *readable, fd_set *writable)
+{
+    int i;
+
+    for (i = 0; i < howmany(XFD_SETSIZE, NFDBITS); i++)
+    {
+	fd_mask read = readable->fds_bits[i];
+	fd_mask write = writable ? writable->fds_bits[i] : 0;
+	fd_mask changed = (read ^ pollRead.fds_bits[i]) |
+			  (write ^ pollWrite.fds_bits[i]);
+
+	while (changed)
+	{
+	    int bit = ffs(changed) - 1;
+	    int fd = i * NFDBITS + bit;
+	    fd_mask m = (fd_mask) 1 << bit;
+
+	    if (OsPollChange(fd, (pollRead.fds_bits[i] & m) != 0,
+			     (pollWrite.fds_bits[i] & m) != 0,
+			     (read & m) != 0, (write & m) != 0) < 0)
+		return -1;
+	    pollRead.fds_bits[i] = (pollRead.fds_bits[i] & ~m) | (read & m);
+	    pollWrite.fds_bits[i] = (pollWrite.fds_bits[i] & ~m) | (write & m);
+	    changed &= ~m;
+	}
+    }
+    return 0;
+}
+
+int
+OsPoll(int maxfds, fd_set *readable, fd_set *writable, struct timeval *wt)
+{
+    int timeout = -1;
+
+    if (pollFd < 0 && !pollBroken)
+    {
+	pollFd = OsPollOpen();
+	pollBroken = pollFd < 0;
+    }
+    if (pollBroken)
+	return Select(maxfds, readable, writable, NULL, wt);
+
+    if (OsPollSync(readable, writable) < 0)
+    {
+	/*
+	 * A closed descriptor is reported like select() would; anything
+	 * else, such as a device the kernel can't watch this way, means
+	 * going back to select() for good.
+	 */
+	if (errno == EBADF)
+	    return -1;
+	ErrorF("OsPoll: falling back to select, errno=%d\n", errno);
+	close(pollFd);
+	pollFd = -1;
+	pollBroken = TRUE;
+	return Select(maxfds, readable, writable, NULL, wt);
+    }
+
+    if (wt)
+	timeout = wt->tv_sec * 1000 + (wt->tv_usec + 999) / 1000;
+    FD_ZERO(readable);
+    if (writable)
+	FD_ZERO(writable);
+    return OsPollWait(readable, writable, timeout);
+}
+
+void
+OsPollForget(int fd)
+{
+    if (pollFd < 0 || (!FD_ISSET(fd, &pollRead) && !FD_ISSET(fd, &pollWrite)))
+	return;
+    OsPollChange(fd, FD_ISSET(fd, &pollRead), FD_ISSET(fd, &pollWrite),
+		 FALSE, FALSE);
+    FD_CLR(fd, &pollRead);
+    FD_CLR(fd, &pollWrite);
+}
+
+#else
+
+int
+OsPoll(int maxfds, fd_set *readable, fd_set *writable, struct timeval *wt)
+{
+    return Select(maxfds, readable, writable, NULL, wt);
+}
+
+void
+OsPollForget(int fd)
+{
+}
+
+#endif
@@ -374,6 +374,23 @@ GiveUp(int sig)
     errno = olderrno;
 }
 
+/*
+ * On SIGUSR2, dump the request accounting at the next wakeup and start
+ * dispatch tracing, or dump the trace when it is already running.
+ */
+
+volatile char ClientStatsPending;
+
+volatile char DispatchTracePending;
+
+/*ARGSUSED*/
+SIGVAL
+DispatchStatsRequest(int sig)
+{
+    ClientStatsPending = TRUE;
+    DispatchTracePending = TRUE;
+}
+
 _X_EXPORT CARD32
 GetTimeInMillis(void)
 {
@@ -389,6 +406,21 @@ GetTimeInMillis(void)
     return(tv.tv_sec * 1000) + (tv.tv_usec / 1000);
 }
 
+_X_EXPORT CARD64
+GetTimeInMicros(void)
+{
+    struct timeval tv;
+
+#ifdef MONOTONIC_CLOCK
+    struct timespec tp;
+    if (clock_gettime(CLOCK_MONOTONIC, &tp) == 0)
+        return ((CARD64) tp.tv_sec * 1000000) + (tp.tv_nsec / 1000);
+#endif
+
+    X_GETTIMEOFDAY(&tv);
+    return ((CARD64) tv.tv_sec * 1000000) + tv.tv_usec;
+}
+
 _X_EXPORT void
 AdjustWaitForDelay (pointer waitTime, unsigned long newdelay)
 {
@@ -470,6 +502,11 @@ void UseMsg(void)
     ErrorF("-t #                   mouse threshold (pixels)\n");
     ErrorF("-tcp                   listen for TCP (default is nolisten tcp)\n");
     ErrorF("-terminate             terminate at server reset\n");
+    ErrorF("-trace file            trace dispatch, dump to file on SIGUSR2\n");
+    ErrorF("                       (each dump restarts the trace)\n");
+    ErrorF("-tracebinary           dump the trace in binary, not CSV\n");
+    ErrorF("-tracesize #           requests kept in the trace, up to %d\n",
+	   DISPATCH_TRACE_MAX_SIZE);
     ErrorF("-to #                  connection time out\n");
     ErrorF("-tst                   disable testing extensions\n");
     ErrorF("ttyxx                  server started from init on /dev/ttyxx\n");
@@ -851,6 +888,31 @@ ProcessCommandLine(int argc, char *argv[])
 		UseMsg();
 	}
 #endif
+	else if ( strcmp( argv[i], "-trace") == 0)
+	{
+	    if (++i < argc)
+	    {
+		DispatchTraceFile = argv[i];
+		DispatchTraceEnabled = TRUE;
+	    }
+	    else
+		UseMsg();
+	}
+	else if ( strcmp( argv[i], "-tracebinary") == 0)
+	{
+	    DispatchTraceBinary = TRUE;
+	}
+	else if ( strcmp( argv[i], "-tracesize") == 0)
+	{
+	    if (++i < argc && atoi(argv[i]) > 0)
+	    {
+		DispatchTraceSize = atoi(argv[i]);
+		if (DispatchTraceSize > DISPATCH_TRACE_MAX_SIZE)
+		    DispatchTraceSize = DISPATCH_TRACE_MAX_SIZE;
+	    }
+	    else
+		UseMsg();
+	}
 	else if ( strcmp( argv[i], "-render" ) == 0)
 	{
 	    if (++i < argc)
@@ -979,101 +1041,140 @@ OsInitAllocator (void)
 #endif
 }
 
-#ifdef SMART_SCHEDULE
+/*
+ * Scratch memory.
+ *
+ * Temporary arrays needed only while one request is being served are
+ * carved off a single arena by bumping an offset, and Dispatch hands all
+ * of it back at once with ScratchReset before the next request.
+ * ScratchFree only reclaims the latest allocation still in the arena,
+ * which is all strictly nested use needs; anything else waits for the
+ * reset.  Allocations that don't fit fall through to malloc, and the
+ * arena grows at the next reset to the most any request had outstanding,
+ * up to SCRATCH_MAX.
+ *
+ * Only the main thread may use it, and nothing from it may live past
+ * the request (or, outside a request, past the next trip through
+ * WaitForSomething).
+ */
 
-unsigned long	SmartScheduleIdleCount;
-Bool		SmartScheduleIdle;
-Bool		SmartScheduleTimerStopped;
+#define SCRATCH_MIN	(64 * 1024)
+#define SCRATCH_MAX	(4 * 1024 * 1024)
+#define SCRATCH_NONE	(~0UL)
 
-#ifdef SIGVTALRM
-#define SMART_SCHEDULE_POSSIBLE
-#endif
+typedef struct _ScratchHeader {
+    unsigned long	size;	/* bytes asked for */
+    unsigned long	prev;	/* offset of the allocation before */
+} ScratchHeader;
 
-#ifdef SMART_SCHEDULE_POSSIBLE
-#define SMART_SCHEDULE_SIGNAL		SIGALRM
-#define SMART_SCHEDULE_TIMER		ITIMER_REAL
-#endif
+static char		*scratchBase;
+static unsigned long	scratchSize;
+static unsigned long	scratchTop;
+static unsigned long	scratchLast = SCRATCH_NONE;
+static unsigned long	scratchOverflow;	/* bytes sent to malloc */
+static unsigned long	scratchPeak;
 
-static void
-SmartScheduleStopTimer (void)
-{
-#ifdef SMART_SCHEDULE_POSSIBLE
-    struct itimerval	timer;
+#define ScratchUsed()	if (scratchTop + scratchOverflow > scratchPeak) \
+			    scratchPeak = scratchTop + scratchOverflow
 
-    timer.it_interval.tv_sec = 0;
-    timer.it_interval.tv_usec = 0;
-    timer.it_value.tv_sec = 0;
-    timer.it_value.tv_usec = 0;
-    (void) setitimer (ITIMER_REAL, &timer, 0);
-    SmartScheduleTimerStopped = TRUE;
-#endif
-}
+#define ScratchRound(n)	(((n) + sizeof(ScratchHeader) + 15) & ~15UL)
+#define ScratchOwns(p)	((char *) (p) >= scratchBase && \
+			 (char *) (p) < scratchBase + scratchSize)
 
-Bool
-SmartScheduleStartTimer (void)
+pointer
+ScratchAlloc(unsigned long size)
 {
-#ifdef SMART_SCHEDULE_POSSIBLE
-    struct itimerval	timer;
+    unsigned long	need = ScratchRound(size);
+    ScratchHeader	*h;
 
-    SmartScheduleTimerStopped = FALSE;
-    timer.it_interval.tv_sec = SmartScheduleInterval / 1000;
-    timer.it_interval.tv_usec = (SmartScheduleInterval % 1000) * 1000;
-    timer.it_value.tv_sec = SmartScheduleInterval / 1000;
-    timer.it_value.tv_usec = (SmartScheduleInterval % 1000) * 1000;
-    return setitimer (ITIMER_REAL, &timer, 0) >= 0;
-#endif
-    return FALSE;
+    if (!scratchBase)
+    {
+	scratchBase = malloc(SCRATCH_MIN);
+	if (scratchBase)
+	    scratchSize = SCRATCH_MIN;
+    }
+    if (need > scratchSize - scratchTop)
+    {
+	scratchOverflow += need;
+	ScratchUsed();
+	return malloc(size);
+    }
+    h = (ScratchHeader *) (scratchBase + scratchTop);
+    h->size = size;
+    h->prev = scratchLast;
+    scratchLast = scratchTop;
+    scratchTop += need;
+    ScratchUsed();
+    return h + 1;
 }
 
-#ifdef SMART_SCHEDULE_POSSIBLE
-static void
-SmartScheduleTimer (int sig)
+pointer
+ScratchRealloc(pointer ptr, unsigned long size)
 {
-    int olderrno = errno;
-
-    SmartScheduleTime += SmartScheduleInterval;
-    if (SmartScheduleIdle)
+    ScratchHeader	*h;
+    unsigned long	offset;
+    pointer		n;
+
+    if (!ptr)
+	return ScratchAlloc(size);
+    if (!ScratchOwns(ptr))
+	return realloc(ptr, size);
+    h = (ScratchHeader *) ptr - 1;
+    offset = (char *) h - scratchBase;
+    /* the latest allocation grows in place when there's room */
+    if (offset == scratchLast && ScratchRound(size) <= scratchSize - offset)
     {
-	SmartScheduleStopTimer ();
+	h->size = size;
+	scratchTop = offset + ScratchRound(size);
+	ScratchUsed();
+	return ptr;
     }
-    errno = olderrno;
+    n = ScratchAlloc(size);
+    if (!n)
+	return NULL;
+    memcpy(n, ptr, min(size, h->size));
+    ScratchFree(ptr);
+    return n;
 }
-#endif
 
-Bool
-SmartScheduleInit (void)
+void
+ScratchFree(pointer ptr)
 {
-#ifdef SMART_SCHEDULE_POSSIBLE
-    struct sigaction	act;
-
-    if (SmartScheduleDisable)
-	return TRUE;
+    ScratchHeader	*h;
 
-    bzero ((char *) &act, sizeof(struct sigaction));
-
-    /* Set up the timer signal function */
-    act.sa_handler = SmartScheduleTimer;
-    sigemptyset (&act.sa_mask);
-    sigaddset (&act.sa_mask, SMART_SCHEDULE_SIGNAL);
-    if (sigaction (SMART_SCHEDULE_SIGNAL, &act, 0) < 0)
+    if (!ptr)
+	return;
+    if (!ScratchOwns(ptr))
     {
-	perror ("sigaction for smart scheduler");
-	return FALSE;
+	free(ptr);
+	return;
     }
-    /* Set up the virtual timer */
-    if (!SmartScheduleStartTimer ())
+    h = (ScratchHeader *) ptr - 1;
+    if ((char *) h - scratchBase == scratchLast)
     {
-	perror ("scheduling timer");
-	return FALSE;
+	scratchTop = scratchLast;
+	scratchLast = h->prev;
     }
-    /* stop the timer and wait for WaitForSomething to start it */
-    SmartScheduleStopTimer ();
-    return TRUE;
-#else
-    return FALSE;
-#endif
 }
-#endif
+
+void
+ScratchReset(void)
+{
+    unsigned long	size;
+
+    scratchTop = 0;
+    scratchLast = SCRATCH_NONE;
+    if (scratchBase && scratchPeak > scratchSize && scratchSize < SCRATCH_MAX)
+    {
+	for (size = scratchSize; size < scratchPeak && size < SCRATCH_MAX;)
+	    size <<= 1;
+	free(scratchBase);
+	scratchBase = malloc(size);
+	scratchSize = scratchBase ? size : 0;
+    }
+    scratchOverflow = 0;
+    scratchPeak = 0;
+}
 
 #ifdef SIG_BLOCK
 static sigset_t	PreviousSignalMask;
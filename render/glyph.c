@@ -465,6 +465,7 @@ FreeGlyph(GlyphPtr glyph, int format)
                 (*ps->UnrealizeGlyph) (screenInfo.screens[i], glyph);
         }
 
+        GlyphAtlasRemove(glyph);
         if (glyph->devPrivates)
             free(glyph->devPrivates);
         free(glyph);
@@ -501,6 +502,7 @@ AddGlyph(GlyphSetPtr glyphSet, GlyphPtr glyph, Glyph id)
         gr->glyph = glyph;
         gr->signature = hash;
         globalGlyphs[glyphSet->fdepth].tableEntries++;
+        GlyphAtlasAdd(glyphSet, glyph);
     }
 
     /* Insert/replace glyphset value */
@@ -560,6 +562,7 @@ AllocateGlyph(xGlyphInfo * gi, int fdepth)
     if (!glyph)
         return 0;
     glyph->refcnt = 0;
+    glyph->atlas = NULL;
     glyph->size = size + sizeof(xGlyphInfo);
     glyph->info = *gi;
 
@@ -705,6 +708,7 @@ FreeGlyphSet(pointer value, XID gid)
 
         GlyphPtr glyph;
 
+        GlyphAtlasFreeSet(glyphSet);
         for (i = 0; i < tableSize; i++) {
             glyph = table[i].glyph;
             if (glyph && glyph != DeletedGlyph)
@@ -0,0 +1,314 @@
+/*
+ *
+ * Copyright © 2026 Ace Husky <acehusky12@gmail.com>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of Ace Husky not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  Ace Husky makes no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * ACE HUSKY DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL ACE HUSKY BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Glyph atlases.
+ *
+ * Each glyph set packs the glyphs it adds into atlas pages, one list of
+ * pages per set, all of the set's format.  Glyphs are placed on shelves
+ * (rows of glyphs of similar height) so a text run samples a handful of
+ * pages instead of one allocation per glyph, and the compositing code
+ * can wrap a whole page in a single picture.  The bits after the
+ * GlyphRec stay authoritative -- glyphs are hashed and shared between
+ * sets on them -- so the atlas is only ever a copy and a glyph that
+ * doesn't fit simply isn't packed.
+ *
+ * Pages start small and double in size, up to GLYPH_ATLAS_WIDTH x
+ * GLYPH_ATLAS_HEIGHT, as glyphs stop fitting, so a set holding a few
+ * glyphs only pays for a few glyphs' worth of copies.
+ *
+ * A glyph lives in the atlas of the first set that added it.  Freeing it
+ * releases its slot; once half of a page has been released the page is
+ * repacked from the glyph bits.  Pages outlive their set while glyphs
+ * shared with other sets still point into them.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "misc.h"
+#include "servermd.h"
+#include "picturestr.h"
+#include "glyphstr.h"
+
+#define GLYPH_ATLAS_WIDTH	512
+#define GLYPH_ATLAS_HEIGHT	256
+
+/* Size of a new page */
+#define GLYPH_ATLAS_MIN_WIDTH	64
+#define GLYPH_ATLAS_MIN_HEIGHT	32
+
+/* Larger glyphs keep to their own bits */
+#define GLYPH_ATLAS_MAX		64
+
+extern const CARD8 glyphDepths[GlyphFormatNum];
+
+static GlyphAtlasPtr
+GlyphAtlasCreate(GlyphSetPtr glyphSet)
+{
+    GlyphAtlasPtr atlas;
+
+    int depth = glyphDepths[glyphSet->fdepth];
+
+    int stride = PixmapBytePad(GLYPH_ATLAS_MIN_WIDTH, depth);
+
+    atlas = calloc(1, sizeof(GlyphAtlasRec));
+    if (!atlas)
+        return NULL;
+    atlas->bits = calloc(GLYPH_ATLAS_MIN_HEIGHT, stride);
+    if (!atlas->bits) {
+        free(atlas);
+        return NULL;
+    }
+    atlas->glyphSet = glyphSet;
+    atlas->depth = depth;
+    atlas->bpp = BitsPerPixel(depth);
+    atlas->width = GLYPH_ATLAS_MIN_WIDTH;
+    atlas->height = GLYPH_ATLAS_MIN_HEIGHT;
+    atlas->stride = stride;
+    atlas->next = glyphSet->atlas;
+    glyphSet->atlas = atlas;
+    return atlas;
+}
+
+static void
+GlyphAtlasDestroy(GlyphAtlasPtr atlas)
+{
+    free(atlas->glyphs);
+    free(atlas->bits);
+    free(atlas);
+}
+
+/*
+ * Double the page, keeping it about twice as wide as it is tall.  Glyphs
+ * keep their place, only the rows move to the new stride; nothing holds
+ * on to the bits between requests.
+ */
+static Bool
+GlyphAtlasGrow(GlyphAtlasPtr atlas)
+{
+    int width = atlas->width, height = atlas->height;
+
+    int stride, y;
+
+    CARD8 *bits;
+
+    if (width < GLYPH_ATLAS_WIDTH && width <= height * 2)
+        width *= 2;
+    else if (height < GLYPH_ATLAS_HEIGHT)
+        height *= 2;
+    else if (width < GLYPH_ATLAS_WIDTH)
+        width *= 2;
+    else
+        return FALSE;
+
+    stride = PixmapBytePad(width, atlas->depth);
+    bits = calloc(height, stride);
+    if (!bits)
+        return FALSE;
+    for (y = 0; y < atlas->top; y++)
+        memcpy(bits + y * stride, atlas->bits + y * atlas->stride,
+               atlas->stride);
+    free(atlas->bits);
+    atlas->bits = bits;
+    atlas->width = width;
+    atlas->height = height;
+    atlas->stride = stride;
+    return TRUE;
+}
+
+/* Slot width of a glyph: whole padded rows, so they copy as bytes */
+static int
+GlyphAtlasSlotWidth(GlyphAtlasPtr atlas, GlyphPtr glyph)
+{
+    return PixmapBytePad(glyph->info.width, atlas->depth) * 8 / atlas->bpp;
+}
+
+static Bool
+GlyphAtlasPlace(GlyphAtlasPtr atlas, GlyphPtr glyph)
+{
+    int w = GlyphAtlasSlotWidth(atlas, glyph);
+
+    int h = glyph->info.height;
+
+    GlyphShelfPtr shelf = NULL;
+
+    int i, rowBytes, y;
+
+    CARD8 *src, *dst;
+
+    if (atlas->nglyphs == atlas->size) {
+        int size = atlas->size ? atlas->size * 2 : 64;
+
+        GlyphPtr *glyphs = realloc(atlas->glyphs, size * sizeof(GlyphPtr));
+
+        if (!glyphs)
+            return FALSE;
+        atlas->glyphs = glyphs;
+        atlas->size = size;
+    }
+
+    for (i = 0; i < atlas->nshelves; i++) {
+        GlyphShelfPtr s = &atlas->shelves[i];
+
+        if (s->height < h || s->height > h + h / 4 + 2 ||
+            s->x + w > atlas->width)
+            continue;
+        if (!shelf || s->height < shelf->height)
+            shelf = s;
+    }
+    if (!shelf) {
+        if (atlas->nshelves == GLYPH_ATLAS_SHELVES ||
+            atlas->top + h > atlas->height || w > atlas->width)
+            return FALSE;
+        shelf = &atlas->shelves[atlas->nshelves++];
+        shelf->x = 0;
+        shelf->y = atlas->top;
+        shelf->height = h;
+        atlas->top += h;
+    }
+
+    glyph->atlas = atlas;
+    glyph->atlasX = shelf->x;
+    glyph->atlasY = shelf->y;
+    glyph->atlasSlot = atlas->nglyphs;
+    atlas->glyphs[atlas->nglyphs++] = glyph;
+    shelf->x += w;
+
+    rowBytes = PixmapBytePad(glyph->info.width, atlas->depth);
+    src = (CARD8 *) (glyph + 1);
+    dst = GlyphBits(glyph);
+    for (y = 0; y < h; y++) {
+        memcpy(dst, src, rowBytes);
+        src += rowBytes;
+        dst += atlas->stride;
+    }
+    return TRUE;
+}
+
+static int
+GlyphAtlasCompareHeight(const void *a, const void *b)
+{
+    return (*(GlyphPtr const *) b)->info.height -
+        (*(GlyphPtr const *) a)->info.height;
+}
+
+/*
+ * Pack the surviving glyphs again, tallest first.  Anything that no
+ * longer fits drops back to its own bits.
+ */
+static void
+GlyphAtlasRepack(GlyphAtlasPtr atlas)
+{
+    GlyphPtr *glyphs = atlas->glyphs;
+
+    int i, n = atlas->nglyphs;
+
+    qsort(glyphs, n, sizeof(GlyphPtr), GlyphAtlasCompareHeight);
+    atlas->glyphs = NULL;
+    atlas->size = 0;
+    atlas->nglyphs = 0;
+    atlas->nshelves = 0;
+    atlas->top = 0;
+    atlas->freed = 0;
+    for (i = 0; i < n; i++)
+        if (!GlyphAtlasPlace(atlas, glyphs[i]))
+            glyphs[i]->atlas = NULL;
+    free(glyphs);
+}
+
+void
+GlyphAtlasAdd(GlyphSetPtr glyphSet, GlyphPtr glyph)
+{
+    GlyphAtlasPtr atlas;
+
+    if (glyph->atlas || !glyph->info.width || !glyph->info.height ||
+        glyph->info.width > GLYPH_ATLAS_MAX ||
+        glyph->info.height > GLYPH_ATLAS_MAX)
+        return;
+    /* depth 4 has no fixed bits per pixel */
+    if (glyphSet->fdepth == GlyphFormat4)
+        return;
+
+    for (atlas = glyphSet->atlas; atlas; atlas = atlas->next)
+        do {
+            if (GlyphAtlasPlace(atlas, glyph))
+                return;
+        } while (GlyphAtlasGrow(atlas));
+    atlas = GlyphAtlasCreate(glyphSet);
+    while (atlas && !GlyphAtlasPlace(atlas, glyph))
+        if (!GlyphAtlasGrow(atlas))
+            break;
+}
+
+void
+GlyphAtlasRemove(GlyphPtr glyph)
+{
+    GlyphAtlasPtr atlas = glyph->atlas;
+
+    GlyphPtr last;
+
+    if (!atlas)
+        return;
+    glyph->atlas = NULL;
+    last = atlas->glyphs[--atlas->nglyphs];
+    atlas->glyphs[glyph->atlasSlot] = last;
+    last->atlasSlot = glyph->atlasSlot;
+    atlas->freed += GlyphAtlasSlotWidth(atlas, glyph) * glyph->info.height;
+
+    if (!atlas->glyphSet) {
+        if (!atlas->nglyphs)
+            GlyphAtlasDestroy(atlas);
+        return;
+    }
+    if (!atlas->nglyphs) {
+        atlas->nshelves = 0;
+        atlas->top = 0;
+        atlas->freed = 0;
+    }
+    else if (atlas->freed * 2 > atlas->top * atlas->width)
+        GlyphAtlasRepack(atlas);
+}
+
+/*
+ * The set is going away; its empty pages go with it, the rest are
+ * released by the last glyph leaving them.
+ */
+void
+GlyphAtlasFreeSet(GlyphSetPtr glyphSet)
+{
+    GlyphAtlasPtr atlas, next;
+
+    for (atlas = glyphSet->atlas; atlas; atlas = next) {
+        next = atlas->next;
+        atlas->glyphSet = NULL;
+        atlas->next = NULL;
+        if (!atlas->nglyphs)
+            GlyphAtlasDestroy(atlas);
+    }
+    glyphSet->atlas = NULL;
+}
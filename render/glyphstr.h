@@ -38,14 +38,51 @@
 #define GlyphFormat32	4
 #define GlyphFormatNum	5
 
+typedef struct _GlyphAtlas *GlyphAtlasPtr;
+
 typedef struct _Glyph {
     CARD32 refcnt;
     DevUnion *devPrivates;
+    GlyphAtlasPtr atlas;        /* page holding a copy of the bits, or NULL */
+    INT16 atlasX, atlasY;
+    int atlasSlot;
     CARD32 size;                /* info + bitmap */
-    xGlyphInfo info;
+    xGlyphInfo info;            /* hashed along with the bits, keep last */
     /* bits follow */
 } GlyphRec, *GlyphPtr;
 
+#define GLYPH_ATLAS_SHELVES	32
+
+typedef struct _GlyphShelf {
+    INT16 x, y;
+    INT16 height;
+} GlyphShelfRec, *GlyphShelfPtr;
+
+typedef struct _GlyphAtlas {
+    GlyphAtlasPtr next;
+    struct _GlyphSet *glyphSet; /* NULL once the set is freed */
+    int depth, bpp;
+    int width, height;
+    int stride;                 /* in bytes */
+    int nshelves;
+    int top;
+    GlyphShelfRec shelves[GLYPH_ATLAS_SHELVES];
+    GlyphPtr *glyphs;
+    int nglyphs, size;
+    int freed;                  /* pixels released since the last repack */
+    CARD8 *bits;
+} GlyphAtlasRec;
+
+#define GlyphAtlasBits(g)	((g)->atlas->bits +				\
+				 (g)->atlasY * (g)->atlas->stride +		\
+				 (g)->atlasX * (g)->atlas->bpp / 8)
+
+/* Where to read a glyph's image from, and its row stride in bytes */
+#define GlyphBits(g)		((g)->atlas ? GlyphAtlasBits(g) :		\
+				 (CARD8 *) ((g) + 1))
+#define GlyphStride(g, depth)	((g)->atlas ? (g)->atlas->stride :		\
+				 PixmapBytePad((g)->info.width, depth))
+
 typedef struct _GlyphRef {
     CARD32 signature;
     GlyphPtr glyph;
@@ -72,6 +109,7 @@ typedef struct _GlyphSet {
     GlyphHashRec hash;
     int maxPrivate;
     pointer *devPrivates;
+    GlyphAtlasPtr atlas;
 } GlyphSetRec, *GlyphSetPtr;
 
 #define GlyphSetGetPrivate(pGlyphSet,n)					\
@@ -145,4 +183,15 @@ GlyphSetPtr AllocateGlyphSet(int fdepth, PictFormatPtr format);
 int
  FreeGlyphSet(pointer value, XID gid);
 
+/* glyphatlas.c */
+
+void
+ GlyphAtlasAdd(GlyphSetPtr glyphSet, GlyphPtr glyph);
+
+void
+ GlyphAtlasRemove(GlyphPtr glyph);
+
+void
+ GlyphAtlasFreeSet(GlyphSetPtr glyphSet);
+
 #endif                          /* _GLYPHSTR_H_ */
@@ -109,6 +109,8 @@ miGlyphs(CARD8 op,
 
     PicturePtr pPicture;
 
+    GlyphAtlasPtr pAtlas = NULL;
+
     PixmapPtr pMaskPixmap = 0;
 
     PicturePtr pMask;
@@ -119,6 +121,8 @@ miGlyphs(CARD8 op,
 
     int x, y;
 
+    int gx, gy;
+
     int xDst = list->xOff, yDst = list->yOff;
 
     int n;
@@ -142,9 +146,8 @@ miGlyphs(CARD8 op,
             return;
         width = extents.x2 - extents.x1;
         height = extents.y2 - extents.y1;
-        pMaskPixmap =
-            (*pScreen->CreatePixmap) (pScreen, width, height,
-                                      maskFormat->depth);
+        pMaskPixmap = miGlyphMaskAcquire(pScreen, maskFormat->depth,
+                                         width, height);
         if (!pMaskPixmap)
             return;
         component_alpha = NeedsComponent(maskFormat->format);
@@ -152,7 +155,7 @@ miGlyphs(CARD8 op,
                               maskFormat, CPComponentAlpha, &component_alpha,
                               serverClient, &error);
         if (!pMask) {
-            (*pScreen->DestroyPixmap) (pMaskPixmap);
+            miGlyphMaskRelease(pScreen, pMaskPixmap);
             return;
         }
         pGC = GetScratchGC(pMaskPixmap->drawable.depth, pScreen);
@@ -196,17 +199,41 @@ miGlyphs(CARD8 op,
                     return;
                 }
             }
-            (*pScreen->ModifyPixmapHeader) (pPixmap,
-                                            glyph->info.width,
-                                            glyph->info.height, 0, 0, -1,
-                                            (pointer) (glyph + 1));
-            pPixmap->drawable.serialNumber = NEXT_SERIAL_NUMBER;
+            /*
+             * Packed glyphs are drawn straight out of their atlas page,
+             * the header only changes when the page does.
+             */
+            if (glyph->atlas) {
+                GlyphAtlasPtr atlas = glyph->atlas;
+
+                if (atlas != pAtlas) {
+                    (*pScreen->ModifyPixmapHeader) (pPixmap,
+                                                    atlas->width,
+                                                    atlas->height, 0, 0,
+                                                    atlas->stride,
+                                                    (pointer) atlas->bits);
+                    pPixmap->drawable.serialNumber = NEXT_SERIAL_NUMBER;
+                    pAtlas = atlas;
+                }
+                gx = glyph->atlasX;
+                gy = glyph->atlasY;
+            }
+            else {
+                (*pScreen->ModifyPixmapHeader) (pPixmap,
+                                                glyph->info.width,
+                                                glyph->info.height, 0, 0, -1,
+                                                (pointer) (glyph + 1));
+                pPixmap->drawable.serialNumber = NEXT_SERIAL_NUMBER;
+                pAtlas = NULL;
+                gx = 0;
+                gy = 0;
+            }
             if (maskFormat) {
                 CompositePicture(PictOpAdd,
                                  pPicture,
                                  None,
                                  pMask,
-                                 0, 0,
+                                 gx, gy,
                                  0, 0,
                                  x - glyph->info.x,
                                  y - glyph->info.y,
@@ -219,7 +246,7 @@ miGlyphs(CARD8 op,
                                  pDst,
                                  xSrc + (x - glyph->info.x) - xDst,
                                  ySrc + (y - glyph->info.y) - yDst,
-                                 0, 0,
+                                 gx, gy,
                                  x - glyph->info.x,
                                  y - glyph->info.y,
                                  glyph->info.width, glyph->info.height);
@@ -233,6 +260,7 @@ miGlyphs(CARD8 op,
             FreePicture((pointer) pPicture, 0);
             pPicture = 0;
             pPixmap = 0;
+            pAtlas = NULL;
         }
     }
     if (maskFormat) {
@@ -245,6 +273,6 @@ miGlyphs(CARD8 op,
                          xSrc + x - xDst,
                          ySrc + y - yDst, 0, 0, x, y, width, height);
         FreePicture((pointer) pMask, (XID) 0);
-        (*pScreen->DestroyPixmap) (pMaskPixmap);
+        miGlyphMaskRelease(pScreen, pMaskPixmap);
     }
 }
@@ -0,0 +1,212 @@
+/*
+ *
+ * Copyright © 2026 Ace Husky <acehusky12@gmail.com>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of Ace Husky not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  Ace Husky makes no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * ACE HUSKY DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL ACE HUSKY BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Scratch glyph mask pixmaps.
+ *
+ * Every glyph run drawn with a mask format needs a temporary pixmap the
+ * size of the run.  Rather than creating and destroying one per request,
+ * each screen keeps a few around, keyed by depth and by width and height
+ * rounded up to a power of two, so runs of similar size share a pixmap.
+ * Callers only clear the part they use.  Pixmaps left unused for
+ * GLYPH_MASK_IDLE milliseconds are released from a timer; oversized runs
+ * bypass the cache altogether.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdlib.h>
+
+#include "scrnintstr.h"
+#include "pixmapstr.h"
+#include "picturestr.h"
+#include "mipict.h"
+
+#define GLYPH_MASK_CACHE	8
+#define GLYPH_MASK_IDLE		5000
+
+#define GLYPH_MASK_MIN_WIDTH	64
+#define GLYPH_MASK_MIN_HEIGHT	16
+#define GLYPH_MASK_MAX_WIDTH	4096
+#define GLYPH_MASK_MAX_HEIGHT	512
+
+typedef struct _miGlyphMask {
+    PixmapPtr pPixmap;
+    int depth;
+    Bool busy;
+    CARD32 lastUsed;
+} miGlyphMaskRec, *miGlyphMaskPtr;
+
+typedef struct _miGlyphMaskCache {
+    ScreenPtr pScreen;
+    OsTimerPtr timer;
+    Bool armed;
+    miGlyphMaskRec masks[GLYPH_MASK_CACHE];
+} miGlyphMaskCacheRec, *miGlyphMaskCachePtr;
+
+static int
+miGlyphMaskClass(int size, int min)
+{
+    while (min < size)
+        min <<= 1;
+    return min;
+}
+
+static CARD32
+miGlyphMaskExpire(OsTimerPtr timer, CARD32 now, pointer arg)
+{
+    miGlyphMaskCachePtr cache = arg;
+
+    ScreenPtr pScreen = cache->pScreen;
+
+    Bool left = FALSE;
+
+    int i;
+
+    for (i = 0; i < GLYPH_MASK_CACHE; i++) {
+        miGlyphMaskPtr mask = &cache->masks[i];
+
+        if (!mask->pPixmap)
+            continue;
+        if (mask->busy || (CARD32) (now - mask->lastUsed) < GLYPH_MASK_IDLE) {
+            left = TRUE;
+            continue;
+        }
+        (*pScreen->DestroyPixmap) (mask->pPixmap);
+        mask->pPixmap = NULL;
+    }
+    cache->armed = left;
+    return left ? GLYPH_MASK_IDLE : 0;
+}
+
+/*
+ * Return a pixmap of at least width x height at the given depth; its
+ * contents are undefined.  Hand it back with miGlyphMaskRelease.
+ */
+PixmapPtr
+miGlyphMaskAcquire(ScreenPtr pScreen, int depth, int width, int height)
+{
+    PictureScreenPtr ps = GetPictureScreen(pScreen);
+
+    miGlyphMaskCachePtr cache = ps->glyphMaskCache;
+
+    miGlyphMaskPtr mask, victim = NULL;
+
+    CARD32 now;
+
+    int i;
+
+    if (width > GLYPH_MASK_MAX_WIDTH || height > GLYPH_MASK_MAX_HEIGHT)
+        return (*pScreen->CreatePixmap) (pScreen, width, height, depth);
+
+    if (!cache) {
+        cache = calloc(1, sizeof(miGlyphMaskCacheRec));
+        if (!cache)
+            return (*pScreen->CreatePixmap) (pScreen, width, height, depth);
+        cache->pScreen = pScreen;
+        ps->glyphMaskCache = cache;
+    }
+
+    width = miGlyphMaskClass(width, GLYPH_MASK_MIN_WIDTH);
+    height = miGlyphMaskClass(height, GLYPH_MASK_MIN_HEIGHT);
+    now = GetTimeInMillis();
+    for (i = 0; i < GLYPH_MASK_CACHE; i++) {
+        mask = &cache->masks[i];
+        if (!mask->pPixmap) {
+            if (!victim || victim->pPixmap)
+                victim = mask;
+            continue;
+        }
+        if (mask->busy)
+            continue;
+        if (mask->depth == depth &&
+            mask->pPixmap->drawable.width == width &&
+            mask->pPixmap->drawable.height == height) {
+            mask->busy = TRUE;
+            return mask->pPixmap;
+        }
+        /* otherwise the least recently used one makes room */
+        if (!victim || (victim->pPixmap &&
+                        (CARD32) (now - mask->lastUsed) >
+                        (CARD32) (now - victim->lastUsed)))
+            victim = mask;
+    }
+    if (!victim)
+        return (*pScreen->CreatePixmap) (pScreen, width, height, depth);
+
+    if (victim->pPixmap)
+        (*pScreen->DestroyPixmap) (victim->pPixmap);
+    victim->pPixmap = (*pScreen->CreatePixmap) (pScreen, width, height, depth);
+    if (!victim->pPixmap)
+        return NULL;
+    victim->depth = depth;
+    victim->busy = TRUE;
+    if (!cache->armed) {
+        cache->timer = TimerSet(cache->timer, 0, GLYPH_MASK_IDLE,
+                                miGlyphMaskExpire, cache);
+        cache->armed = cache->timer != NULL;
+    }
+    return victim->pPixmap;
+}
+
+void
+miGlyphMaskRelease(ScreenPtr pScreen, PixmapPtr pPixmap)
+{
+    miGlyphMaskCachePtr cache = GetPictureScreen(pScreen)->glyphMaskCache;
+
+    int i;
+
+    if (cache) {
+        for (i = 0; i < GLYPH_MASK_CACHE; i++) {
+            miGlyphMaskPtr mask = &cache->masks[i];
+
+            if (mask->pPixmap == pPixmap) {
+                mask->busy = FALSE;
+                mask->lastUsed = GetTimeInMillis();
+                return;
+            }
+        }
+    }
+    (*pScreen->DestroyPixmap) (pPixmap);
+}
+
+void
+miGlyphMaskFini(ScreenPtr pScreen)
+{
+    PictureScreenPtr ps = GetPictureScreen(pScreen);
+
+    miGlyphMaskCachePtr cache = ps->glyphMaskCache;
+
+    int i;
+
+    if (!cache)
+        return;
+    TimerFree(cache->timer);
+    for (i = 0; i < GLYPH_MASK_CACHE; i++)
+        if (cache->masks[i].pPixmap)
+            (*pScreen->DestroyPixmap) (cache->masks[i].pPixmap);
+    free(cache);
+    ps->glyphMaskCache = NULL;
+}
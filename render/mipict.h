@@ -47,6 +47,23 @@ typedef struct _miIndexed {
 
 #define miIndexToEntY24(mif,rgb24) ((mif)->ent[CvtR8G8B8toY15(rgb24)])
 
+typedef struct _miSpanComposite {
+    CARD8 op;
+    PicturePtr pSrc;
+    PicturePtr pDst;
+    PicturePtr pMask;
+    PixmapPtr pPixmap;
+    CARD8 *strip;
+    int stride;
+    int n;                      /* coverage bits to sample for */
+    int scale;                  /* coverage to a8 */
+    int width, height;
+    int xSrc, ySrc;
+    int xDst, yDst;
+    int y, rows;                /* rows of the strip in use */
+    int x1, x2;
+} miSpanCompositeRec, *miSpanCompositePtr;
+
 int
  miCreatePicture(PicturePtr pPicture);
 
@@ -113,6 +130,15 @@ miGlyphs(CARD8 op,
          INT16 xSrc,
          INT16 ySrc, int nlist, GlyphListPtr list, GlyphPtr * glyphs);
 
+PixmapPtr
+miGlyphMaskAcquire(ScreenPtr pScreen, int depth, int width, int height);
+
+void
+ miGlyphMaskRelease(ScreenPtr pScreen, PixmapPtr pPixmap);
+
+void
+ miGlyphMaskFini(ScreenPtr pScreen);
+
 void
  miRenderColorToPixel(PictFormatPtr pPict, xRenderColor * color, CARD32 *pixel);
 
@@ -128,6 +154,22 @@ miCompositeRects(CARD8 op,
                  PicturePtr pDst,
                  xRenderColor * color, int nRect, xRectangle *rects);
 
+Bool
+
+miSpanCompositeInit(miSpanCompositePtr span,
+                    CARD8 op,
+                    PicturePtr pSrc,
+                    PicturePtr pDst,
+                    PictFormatPtr maskFormat,
+                    INT16 xSrc, INT16 ySrc, INT16 xDst, INT16 yDst,
+                    BoxPtr bounds);
+
+void
+ miSpanComposite(pointer closure, int y, int x, int len, CARD8 *coverage);
+
+void
+ miSpanCompositeFini(miSpanCompositePtr span);
+
 void
  miTrapezoidBounds(int ntrap, xTrapezoid * traps, BoxPtr box);
 
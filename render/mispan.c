@@ -0,0 +1,226 @@
+/*
+ *
+ * Copyright © 2026 Ace Husky <acehusky12@gmail.com>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of Ace Husky not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  Ace Husky makes no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * ACE HUSKY DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL ACE HUSKY BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Span compositing.
+ *
+ * A rasterizer producing runs of coverage (see RenderSpanProc) can feed
+ * them straight to miSpanComposite instead of drawing a mask.  Runs are
+ * collected into a strip of at most MI_SPAN_ROWS scanlines which is
+ * composited as soon as the next run falls outside it, so the mask never
+ * holds more than a few rows, rows without coverage are never composited
+ * and only the touched width of each strip is.
+ *
+ * Skipping pixels without coverage is only the same as compositing them
+ * with a zero mask for operators that leave the destination alone under
+ * a transparent source; miSpanCompositeInit refuses the others.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "scrnintstr.h"
+#include "pixmapstr.h"
+#include "servermd.h"
+#include "picturestr.h"
+#include "mipict.h"
+
+#define MI_SPAN_ROWS	8
+
+static Bool
+miSpanOpBounded(CARD8 op)
+{
+    switch (op) {
+    case PictOpDst:
+    case PictOpOver:
+    case PictOpOverReverse:
+    case PictOpOutReverse:
+    case PictOpAtop:
+    case PictOpXor:
+    case PictOpAdd:
+    case PictOpSaturate:
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static void
+miSpanFlush(miSpanCompositePtr span)
+{
+    int y;
+
+    if (!span->rows)
+        return;
+    CompositePicture(span->op, span->pSrc, span->pMask, span->pDst,
+                     span->xSrc + span->x1, span->ySrc + span->y,
+                     span->x1, 0,
+                     span->xDst + span->x1, span->yDst + span->y,
+                     span->x2 - span->x1, span->rows);
+    for (y = 0; y < span->rows; y++)
+        memset(span->strip + y * span->stride + span->x1, 0,
+               span->x2 - span->x1);
+    span->rows = 0;
+}
+
+/*
+ * Set up to composite pSrc onto pDst through runs of coverage for a
+ * shape whose mask, in maskFormat, would cover bounds.  The runs are
+ * expected relative to span->xDst, span->yDst, within span->width x
+ * span->height and sampled for span->n bits.  Returns FALSE when the
+ * operator or mask format can't be handled this way.
+ */
+Bool
+miSpanCompositeInit(miSpanCompositePtr span,
+                    CARD8 op,
+                    PicturePtr pSrc,
+                    PicturePtr pDst,
+                    PictFormatPtr maskFormat,
+                    INT16 xSrc, INT16 ySrc, INT16 xDst, INT16 yDst,
+                    BoxPtr bounds)
+{
+    ScreenPtr pScreen = pDst->pDrawable->pScreen;
+
+    PictFormatPtr pFormat;
+
+    BoxRec box = *bounds;
+
+    BoxPtr pClip;
+
+    int error;
+
+    if (!miSpanOpBounded(op) || !pDst->pDrawable)
+        return FALSE;
+    switch (maskFormat->format) {
+    case PICT_a1:
+        span->n = 1;
+        span->scale = 0xff;
+        break;
+    case PICT_a4:
+        span->n = 4;
+        span->scale = 0x11;
+        break;
+    case PICT_a8:
+        span->n = 8;
+        span->scale = 1;
+        break;
+    default:
+        return FALSE;
+    }
+    pFormat = PictureMatchFormat(pScreen, 8, PICT_a8);
+    if (!pFormat)
+        return FALSE;
+
+    /* nothing outside the destination clip needs rasterizing */
+    ValidatePicture(pDst);
+    pClip = REGION_EXTENTS(pDst->pCompositeClip);
+    box.x1 = max(box.x1, pClip->x1 - pDst->pDrawable->x);
+    box.y1 = max(box.y1, pClip->y1 - pDst->pDrawable->y);
+    box.x2 = min(box.x2, pClip->x2 - pDst->pDrawable->x);
+    box.y2 = min(box.y2, pClip->y2 - pDst->pDrawable->y);
+
+    span->op = op;
+    span->pSrc = pSrc;
+    span->pDst = pDst;
+    span->xSrc = box.x1 + xSrc - xDst;
+    span->ySrc = box.y1 + ySrc - yDst;
+    span->xDst = box.x1;
+    span->yDst = box.y1;
+    span->width = max(box.x2 - box.x1, 0);
+    span->height = max(box.y2 - box.y1, 0);
+    span->rows = 0;
+    span->pMask = NULL;
+    span->pPixmap = NULL;
+    span->strip = NULL;
+    if (!span->width || !span->height)
+        return TRUE;
+
+    span->stride = PixmapBytePad(span->width, 8);
+    span->strip = calloc(MI_SPAN_ROWS, span->stride);
+    if (!span->strip)
+        return FALSE;
+    span->pPixmap = GetScratchPixmapHeader(pScreen, span->width,
+                                           MI_SPAN_ROWS, 8, 8, span->stride,
+                                           span->strip);
+    if (span->pPixmap)
+        span->pMask = CreatePicture(0, &span->pPixmap->drawable, pFormat,
+                                    0, 0, serverClient, &error);
+    if (!span->pMask) {
+        miSpanCompositeFini(span);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * A RenderSpanProc: gather the run into the strip, compositing the strip
+ * first if the run doesn't continue it.
+ */
+void
+miSpanComposite(pointer closure, int y, int x, int len, CARD8 *coverage)
+{
+    miSpanCompositePtr span = (miSpanCompositePtr) closure;
+
+    CARD8 *row;
+
+    int i;
+
+    if (span->rows && (y > span->y + span->rows ||
+                       y - span->y >= MI_SPAN_ROWS))
+        miSpanFlush(span);
+    if (!span->rows) {
+        span->y = y;
+        span->x1 = x;
+        span->x2 = x + len;
+    }
+    else {
+        span->x1 = min(span->x1, x);
+        span->x2 = max(span->x2, x + len);
+    }
+    span->rows = y - span->y + 1;
+
+    row = span->strip + (y - span->y) * span->stride + x;
+    if (span->scale == 1)
+        memcpy(row, coverage, len);
+    else
+        for (i = 0; i < len; i++)
+            row[i] = coverage[i] * span->scale;
+}
+
+void
+miSpanCompositeFini(miSpanCompositePtr span)
+{
+    if (span->pMask) {
+        miSpanFlush(span);
+        FreePicture((pointer) span->pMask, 0);
+    }
+    if (span->pPixmap)
+        FreeScratchPixmapHeader(span->pPixmap);
+    free(span->strip);
+    span->pMask = NULL;
+    span->pPixmap = NULL;
+    span->strip = NULL;
+}
@@ -33,6 +33,7 @@
 #include "mi.h"
 #include "picturestr.h"
 #include "mipict.h"
+#include "renderedge.h"
 
 PicturePtr
 miCreateAlphaPicture(ScreenPtr pScreen,
@@ -158,12 +159,32 @@ miTrapezoids(CARD8 op,
 
         INT16 xRel, yRel;
 
+        miSpanCompositeRec span;
+
         xDst = traps[0].left.p1.x >> 16;
         yDst = traps[0].left.p1.y >> 16;
 
         miTrapezoidBounds(ntrap, traps, &bounds);
         if (bounds.y1 >= bounds.y2 || bounds.x1 >= bounds.x2)
             return;
+
+        /*
+         * Composite runs of coverage as they're rasterized, a few rows
+         * at a time, rather than drawing the whole mask first
+         */
+        if (miSpanCompositeInit(&span, op, pSrc, pDst, maskFormat,
+                                xSrc, ySrc, xDst, yDst, &bounds)) {
+            Bool done = TRUE;
+
+            if (span.width && span.height)
+                done = RenderSweepTrapezoids(span.n, span.width, span.height,
+                                             -span.xDst, -span.yDst,
+                                             ntrap, traps,
+                                             miSpanComposite, &span);
+            miSpanCompositeFini(&span);
+            if (done)
+                return;
+        }
         pPicture = miCreateAlphaPicture(pScreen, pDst, maskFormat,
                                         bounds.x2 - bounds.x1,
                                         bounds.y2 - bounds.y1);
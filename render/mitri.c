@@ -32,6 +32,7 @@
 #include "mi.h"
 #include "picturestr.h"
 #include "mipict.h"
+#include "renderedge.h"
 
 void
 miPointFixedBounds(int npoint, xPointFixed * points, BoxPtr bounds)
@@ -95,12 +96,29 @@ miTriangles(CARD8 op,
 
         INT16 xRel, yRel;
 
+        miSpanCompositeRec span;
+
         xDst = tris[0].p1.x >> 16;
         yDst = tris[0].p1.y >> 16;
 
         miTriangleBounds(ntri, tris, &bounds);
         if (bounds.x2 <= bounds.x1 || bounds.y2 <= bounds.y1)
             return;
+
+        /* As for trapezoids, no full sized mask when runs will do */
+        if (miSpanCompositeInit(&span, op, pSrc, pDst, maskFormat,
+                                xSrc, ySrc, xDst, yDst, &bounds)) {
+            Bool done = TRUE;
+
+            if (span.width && span.height)
+                done = RenderSweepTriangles(span.n, span.width, span.height,
+                                            -span.xDst, -span.yDst,
+                                            ntri, tris,
+                                            miSpanComposite, &span);
+            miSpanCompositeFini(&span);
+            if (done)
+                return;
+        }
         pPicture = miCreateAlphaPicture(pScreen, pDst, maskFormat,
                                         bounds.x2 - bounds.x1,
                                         bounds.y2 - bounds.y1);
@@ -40,6 +40,7 @@
 #include "gcstruct.h"
 #include "servermd.h"
 #include "picturestr.h"
+#include "mipict.h"
 
 _X_EXPORT int PictureScreenPrivateIndex = -1;
 
@@ -98,6 +99,7 @@ PictureCloseScreen(int index, ScreenPtr pScreen)
 
     int n;
 
+    miGlyphMaskFini(pScreen);
     pScreen->CloseScreen = ps->CloseScreen;
     ret = (*pScreen->CloseScreen) (index, pScreen);
     PictureResetFilters(pScreen);
@@ -681,6 +683,8 @@ PictureInit(ScreenPtr pScreen, PictFormatPtr formats, int nformats)
 
     ps->subpixel = SubPixelUnknown;
 
+    ps->glyphMaskCache = 0;
+
     ps->CloseScreen = pScreen->CloseScreen;
     ps->DestroyWindow = pScreen->DestroyWindow;
     ps->StoreColors = pScreen->StoreColors;
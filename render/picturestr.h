@@ -358,6 +358,8 @@ typedef struct _PictureScreen {
     RealizeGlyphProcPtr RealizeGlyph;
     UnrealizeGlyphProcPtr UnrealizeGlyph;
 
+    pointer glyphMaskCache;     /* scratch mask pixmaps, see miglyphmask.c */
+
 } PictureScreenRec, *PictureScreenPtr;
 
 extern int PictureScreenPrivateIndex;
@@ -110,4 +110,29 @@ RenderLineFixedEdgeInit(RenderEdge * e,
                         int bpp,
                         xFixed y, xLineFixed * line, int x_off, int y_off);
 
+/*
+ * Receives the coverage of pixels x .. x + len - 1 on scanline y, from 0
+ * to MAX_ALPHA(n).  Runs arrive in increasing y, and increasing x within
+ * a scanline; coverage may contain zeros between covered pixels.
+ */
+typedef void (*RenderSpanProc) (pointer closure,
+                                int y, int x, int len, CARD8 *coverage);
+
+Bool
+
+RenderSweepTrapezoids(int n, int width, int height, int x_off, int y_off,
+                      int ntrap, xTrapezoid * traps,
+                      RenderSpanProc proc, pointer closure);
+
+Bool
+
+RenderSweepTraps(int n, int width, int height, int x_off, int y_off,
+                 int ntrap, xTrap * traps, RenderSpanProc proc, pointer closure);
+
+Bool
+
+RenderSweepTriangles(int n, int width, int height, int x_off, int y_off,
+                     int ntri, xTriangle * tris,
+                     RenderSpanProc proc, pointer closure);
+
 #endif                          /* _RENDEREDGE_H_ */
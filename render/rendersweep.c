@@ -0,0 +1,440 @@
+/*
+ *
+ * Copyright © 2026 Ace Husky <acehusky12@gmail.com>
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of Ace Husky not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  Ace Husky makes no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * ACE HUSKY DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL ACE HUSKY BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Sweep-line rasterization of trapezoid and triangle arrays.
+ *
+ * All shapes of a request are turned into edge pairs, sorted by their
+ * first sample row and swept top to bottom together: pairs enter the
+ * active list when the sweep reaches them and leave it past their last
+ * row.  Each sample row adds the coverage of every active span into a
+ * difference array for the current scanline, so a span costs the same
+ * whatever its length.  Finished scanlines are handed to the caller as
+ * runs of coverage, skipping the empty stretches between shapes and the
+ * rows nothing touches.
+ *
+ * The sample grid, edge stepping and clipping are those of the per-shape
+ * rasterizers and coverage from overlapping shapes adds up, saturating
+ * at MAX_ALPHA(n), so the results are the same as rasterizing the shapes
+ * one at a time into a mask.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdlib.h>
+
+#include "renderedge.h"
+
+/* Runs are split where at least this many uncovered pixels separate them */
+#define SWEEP_RUN_GAP	8
+
+typedef struct _RenderSweepTrap {
+    RenderEdge l, r;
+    xFixed t, b;
+} RenderSweepTrapRec, *RenderSweepTrapPtr;
+
+typedef struct _RenderSweep {
+    int n;
+    int width, height;
+    int ntrap;
+    RenderSweepTrapPtr traps;
+} RenderSweepRec, *RenderSweepPtr;
+
+static Bool
+RenderSweepInit(RenderSweepPtr sweep, int n, int width, int height, int size)
+{
+    sweep->n = n;
+    sweep->width = width;
+    sweep->height = height;
+    sweep->ntrap = 0;
+    sweep->traps = malloc(size * sizeof(RenderSweepTrapRec));
+    return sweep->traps != NULL;
+}
+
+/*
+ * Clip the vertical extent [top, bottom] to the sample rows inside the
+ * raster; returns the slot for the pair or NULL when no row is left.
+ */
+static RenderSweepTrapPtr
+RenderSweepAdd(RenderSweepPtr sweep, xFixed top, xFixed bottom)
+{
+    RenderSweepTrapPtr trap = &sweep->traps[sweep->ntrap];
+
+    if (top < 0)
+        top = 0;
+    trap->t = RenderSampleCeilY(top, sweep->n);
+    if (xFixedToInt(bottom) >= sweep->height)
+        bottom = IntToxFixed(sweep->height) - 1;
+    trap->b = RenderSampleFloorY(bottom, sweep->n);
+    if (trap->b < trap->t)
+        return NULL;
+    return trap;
+}
+
+static void
+RenderSweepAddTrapezoid(RenderSweepPtr sweep, xTrapezoid * trap,
+                        int x_off, int y_off)
+{
+    xFixed y_off_fixed = IntToxFixed(y_off);
+
+    RenderSweepTrapPtr st;
+
+    if (trap->left.p1.y == trap->left.p2.y ||
+        trap->right.p1.y == trap->right.p2.y)
+        return;
+    st = RenderSweepAdd(sweep, trap->top + y_off_fixed,
+                        trap->bottom + y_off_fixed);
+    if (!st)
+        return;
+    RenderLineFixedEdgeInit(&st->l, sweep->n, st->t, &trap->left,
+                            x_off, y_off);
+    RenderLineFixedEdgeInit(&st->r, sweep->n, st->t, &trap->right,
+                            x_off, y_off);
+    sweep->ntrap++;
+}
+
+static int
+RenderSweepCompare(const void *a, const void *b)
+{
+    xFixed ta = ((const RenderSweepTrapRec *) a)->t;
+
+    xFixed tb = ((const RenderSweepTrapRec *) b)->t;
+
+    return ta < tb ? -1 : ta > tb;
+}
+
+/*
+ * Emit the coverage accumulated for scanline y over [x1, x2) and clear
+ * the accumulator behind it.
+ */
+static void
+RenderSweepFlush(RenderSweepPtr sweep, int *acc, CARD8 *cover, int y,
+                 int x1, int x2, RenderSpanProc proc, pointer closure)
+{
+    int maxAlpha = MAX_ALPHA(sweep->n);
+
+    int sum = 0, start = -1, last = 0;
+
+    int x;
+
+    for (x = x1; x < x2; x++) {
+        sum += acc[x];
+        acc[x] = 0;
+        cover[x] = sum > maxAlpha ? maxAlpha : sum;
+        if (!cover[x])
+            continue;
+        if (start >= 0 && x - last > SWEEP_RUN_GAP) {
+            (*proc) (closure, y, start, last + 1 - start, cover + start);
+            start = -1;
+        }
+        if (start < 0)
+            start = x;
+        last = x;
+    }
+    acc[x2] = 0;
+    if (start >= 0)
+        (*proc) (closure, y, start, last + 1 - start, cover + start);
+}
+
+static Bool
+RenderSweepRun(RenderSweepPtr sweep, RenderSpanProc proc, pointer closure)
+{
+    int n = sweep->n;
+
+    int width = sweep->width;
+
+    int nx = N_X_FRAC(n);
+
+    RenderSweepTrapPtr *active;
+
+    int *acc;
+
+    CARD8 *cover;
+
+    int nactive = 0, next = 0;
+
+    int i, x1, x2;
+
+    xFixed y;
+
+    if (!sweep->ntrap)
+        return TRUE;
+    qsort(sweep->traps, sweep->ntrap, sizeof(RenderSweepTrapRec),
+          RenderSweepCompare);
+
+    active = malloc(sweep->ntrap * sizeof(RenderSweepTrapPtr));
+    acc = calloc(width + 2, sizeof(int));
+    cover = malloc(width + 1);
+    if (!active || !acc || !cover) {
+        free(active);
+        free(acc);
+        free(cover);
+        return FALSE;
+    }
+
+    x1 = width;
+    x2 = 0;
+    y = sweep->traps[0].t;
+    for (;;) {
+        /* pairs starting on this sample row enter the active list */
+        while (next < sweep->ntrap && sweep->traps[next].t == y)
+            active[nactive++] = &sweep->traps[next++];
+
+        for (i = 0; i < nactive;) {
+            RenderSweepTrapPtr trap = active[i];
+
+            RenderEdge *l = &trap->l, *r = &trap->r;
+
+            xFixed lx, rx;
+
+            if (trap->b < y) {
+                active[i] = active[--nactive];
+                continue;
+            }
+
+            lx = l->x;
+            if (lx < 0)
+                lx = 0;
+            rx = r->x;
+            if (xFixedToInt(rx) >= width)
+                rx = IntToxFixed(width);
+
+            /* Skip empty (or backwards) sections */
+            if (rx > lx) {
+                int lxi = xFixedToInt(lx), rxi = xFixedToInt(rx);
+
+                int lxs = RenderSamplesX(lx, n), rxs = RenderSamplesX(rx, n);
+
+                /*
+                 * Partial coverage at both ends, full coverage between,
+                 * as differences from the pixel to the left.
+                 */
+                acc[lxi] += nx - lxs;
+                acc[lxi + 1] += lxs;
+                acc[rxi] += rxs - nx;
+                acc[rxi + 1] -= rxs;
+                if (lxi < x1)
+                    x1 = lxi;
+                if (rxi + 1 > x2)
+                    x2 = rxi + 1;
+            }
+
+            if (xFixedFrac(y) != Y_FRAC_LAST(n)) {
+                RenderEdgeStepSmall(l);
+                RenderEdgeStepSmall(r);
+            }
+            else {
+                RenderEdgeStepBig(l);
+                RenderEdgeStepBig(r);
+            }
+            i++;
+        }
+
+        if (xFixedFrac(y) == Y_FRAC_LAST(n)) {
+            if (x1 < x2) {
+                RenderSweepFlush(sweep, acc, cover, xFixedToInt(y),
+                                 x1, min(x2, width), proc, closure);
+                acc[x2] = 0;
+                x1 = width;
+                x2 = 0;
+            }
+            if (!nactive) {
+                /* nothing left on this scanline, jump to the next pair */
+                if (next == sweep->ntrap)
+                    break;
+                y = sweep->traps[next].t;
+                continue;
+            }
+            y += STEP_Y_BIG(n);
+        }
+        else
+            y += STEP_Y_SMALL(n);
+    }
+
+    free(active);
+    free(acc);
+    free(cover);
+    return TRUE;
+}
+
+/*
+ * Rasterize trapezoids at x_off, y_off into a width x height raster
+ * sampled for n bits of alpha, passing each scanline's coverage runs to
+ * proc.  Returns FALSE if memory ran out before anything was drawn.
+ */
+_X_EXPORT Bool
+RenderSweepTrapezoids(int n, int width, int height, int x_off, int y_off,
+                      int ntrap, xTrapezoid * traps,
+                      RenderSpanProc proc, pointer closure)
+{
+    RenderSweepRec sweep;
+
+    Bool ret;
+
+    if (ntrap <= 0 || width <= 0 || height <= 0)
+        return TRUE;
+    if (!RenderSweepInit(&sweep, n, width, height, ntrap))
+        return FALSE;
+    for (; ntrap; ntrap--, traps++)
+        RenderSweepAddTrapezoid(&sweep, traps, x_off, y_off);
+    ret = RenderSweepRun(&sweep, proc, closure);
+    free(sweep.traps);
+    return ret;
+}
+
+_X_EXPORT Bool
+RenderSweepTraps(int n, int width, int height, int x_off, int y_off,
+                 int ntrap, xTrap * traps, RenderSpanProc proc, pointer closure)
+{
+    RenderSweepRec sweep;
+
+    xFixed x_off_fixed = IntToxFixed(x_off);
+
+    xFixed y_off_fixed = IntToxFixed(y_off);
+
+    Bool ret;
+
+    if (ntrap <= 0 || width <= 0 || height <= 0)
+        return TRUE;
+    if (!RenderSweepInit(&sweep, n, width, height, ntrap))
+        return FALSE;
+    for (; ntrap; ntrap--, traps++) {
+        RenderSweepTrapPtr st;
+
+        if (traps->top.y == traps->bot.y)
+            continue;
+        st = RenderSweepAdd(&sweep, traps->top.y + y_off_fixed,
+                            traps->bot.y + y_off_fixed);
+        if (!st)
+            continue;
+        RenderEdgeInit(&st->l, n, st->t,
+                       traps->top.l + x_off_fixed,
+                       traps->top.y + y_off_fixed,
+                       traps->bot.l + x_off_fixed, traps->bot.y + y_off_fixed);
+        RenderEdgeInit(&st->r, n, st->t,
+                       traps->top.r + x_off_fixed,
+                       traps->top.y + y_off_fixed,
+                       traps->bot.r + x_off_fixed, traps->bot.y + y_off_fixed);
+        sweep.ntrap++;
+    }
+    ret = RenderSweepRun(&sweep, proc, closure);
+    free(sweep.traps);
+    return ret;
+}
+
+static int
+_GreaterY(xPointFixed * a, xPointFixed * b)
+{
+    if (a->y == b->y)
+        return a->x > b->x;
+    return a->y > b->y;
+}
+
+/*
+ * Note that the definition of this function is a bit odd because
+ * of the X coordinate space (y increasing downwards).
+ */
+static int
+_Clockwise(xPointFixed * ref, xPointFixed * a, xPointFixed * b)
+{
+    xPointFixed ad, bd;
+
+    ad.x = a->x - ref->x;
+    ad.y = a->y - ref->y;
+    bd.x = b->x - ref->x;
+    bd.y = b->y - ref->y;
+
+    return ((xFixed_32_32) bd.y * ad.x - (xFixed_32_32) ad.y * bd.x) < 0;
+}
+
+/*
+ * Triangles are split at their middle vertex into two trapezoids, the
+ * upper one sharing the top vertex and the lower one the bottom vertex.
+ */
+_X_EXPORT Bool
+RenderSweepTriangles(int n, int width, int height, int x_off, int y_off,
+                     int ntri, xTriangle * tris,
+                     RenderSpanProc proc, pointer closure)
+{
+    RenderSweepRec sweep;
+
+    xPointFixed *top, *left, *right, *tmp;
+
+    xTrapezoid trap;
+
+    Bool ret;
+
+    if (ntri <= 0 || width <= 0 || height <= 0)
+        return TRUE;
+    if (!RenderSweepInit(&sweep, n, width, height, ntri * 2))
+        return FALSE;
+    for (; ntri; ntri--, tris++) {
+        top = &tris->p1;
+        left = &tris->p2;
+        right = &tris->p3;
+        if (_GreaterY(top, left)) {
+            tmp = left;
+            left = top;
+            top = tmp;
+        }
+        if (_GreaterY(top, right)) {
+            tmp = right;
+            right = top;
+            top = tmp;
+        }
+        if (_Clockwise(top, right, left)) {
+            tmp = right;
+            right = left;
+            left = tmp;
+        }
+
+        trap.top = top->y;
+        trap.left.p1 = *top;
+        trap.left.p2 = *left;
+        trap.right.p1 = *top;
+        trap.right.p2 = *right;
+        if (right->y < left->y)
+            trap.bottom = right->y;
+        else
+            trap.bottom = left->y;
+        RenderSweepAddTrapezoid(&sweep, &trap, x_off, y_off);
+        if (right->y < left->y) {
+            trap.top = right->y;
+            trap.bottom = left->y;
+            trap.right.p1 = *right;
+            trap.right.p2 = *left;
+        }
+        else {
+            trap.top = left->y;
+            trap.bottom = right->y;
+            trap.left.p1 = *left;
+            trap.left.p2 = *right;
+        }
+        RenderSweepAddTrapezoid(&sweep, &trap, x_off, y_off);
+    }
+    ret = RenderSweepRun(&sweep, proc, closure);
+    free(sweep.traps);
+    return ret;
+}